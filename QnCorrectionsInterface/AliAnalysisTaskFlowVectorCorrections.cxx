@@ -8,12 +8,23 @@ Instructions in AddTask_EPcorrectionsExample.C
  */
 
 #include <Riostream.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
 
 #include <TGrid.h>
+#include <TThread.h>
+#include <TSystem.h>
 #include <TROOT.h>
 #include <TTimeStamp.h>
 #include <TStopwatch.h>
 #include <TChain.h>
+#include <TH1F.h>
+#include <TObjString.h>
+#include <TObjArray.h>
 #include <AliInputEventHandler.h>
 #include <AliESDInputHandler.h>
 #include <AliAODInputHandler.h>
@@ -23,10 +34,17 @@ Instructions in AddTask_EPcorrectionsExample.C
 #include "AliQnCorrectionsCutsSet.h"
 #include "AliQnCorrectionsManager.h"
 #include "AliQnCorrectionsHistos.h"
+#include "AliQnCorrectionsQnVector.h"
+#include "AliQnCorrectionsColumnarWriter.h"
+#include "AliQnCorrectionsSparseHistograms.h"
+#include "AliQnCorrectionsCalibrationCache.h"
+#include "AliQnCorrectionsRunIndexedCalibration.h"
 #include "AliLog.h"
 
 #include "AliAnalysisTaskFlowVectorCorrections.h"
 
+extern char **environ;
+
 ClassImp(AliAnalysisTaskFlowVectorCorrections)
 
 
@@ -35,13 +53,53 @@ AliQnCorrectionsFillEventTask(),
 fCalibrateByRun(kTRUE),
 fCalibrationFile(""),
 fCalibrationFileSource(CALIBSRC_local),
+fCalibrationCache(NULL),
+fCalibrationPrefetchRuns(""),
+fRunIndexedCalibration(kFALSE),
+fRunIndexedCalibrationFile(NULL),
+fBackgroundCalibrationPrefetch(kFALSE),
+fCalibrationPrefetchThread(NULL),
+fPrefetchedRun(-1),
+fPrefetchMode(PREFETCH_none),
+fPrefetchSource(),
+fPrefetchDestination(),
+fPrefetchOffset(0),
+fPrefetchLength(-1),
+fPrefetchSucceeded(kFALSE),
+fNoOfCalibrationWaits(0),
+fNoOfSynchronousCalibrationFetches(0),
+fCalibrationWaitTime(0.0),
 fTriggerMask(0),
 fEventQAList(0x0),
 fEventCuts(NULL),
 fLabel(""),
 fQAhistograms(""),
 fFillEventQA(kFALSE),
+fQATier(QATIER_full),
+fTrackQAPrescale(1),
+fTrackQASampleHist(NULL),
 fProvideQnVectorsList(kFALSE),
+fFillColumnarQnVectors(kFALSE),
+fColumnarQnVectorsFileName("QnVectorsColumnar.qncol"),
+fColumnarQnVectorsBatchSize(4096),
+fColumnarQnVectorsMaxHarmonic(4),
+fColumnarQnVectorsEventVariables(""),
+fSparseHistograms(kFALSE),
+fSparseOutputHistogramsList(NULL),
+fSparseQAHistogramsList(NULL),
+fSparseNveQAHistogramsList(NULL),
+fColumnarQnVectorsWriter(NULL),
+fColumnarQnVectorsNoOfEventVariables(0),
+fColumnarQnVectorsEventVarIds(NULL),
+fColumnarQnVectorsNoOfQnVectors(0),
+fNoOfQnVectorSubscriptions(0),
+fQnVectorSubscriptionsResolved(kFALSE),
+fSubscriptionConfiguration(),
+fSubscriptionExpectedStep(),
+fSubscriptionAlternativeStep(),
+fSubscriptionExpectedQnVector(),
+fSubscriptionAlternativeQnVector(),
+fSubscribedQnVector(),
 fOutputSlotEventQA(-1),
 fOutputSlotHistQA(-1),
 fOutputSlotHistNveQA(-1),
@@ -60,13 +118,53 @@ AliAnalysisTaskFlowVectorCorrections::AliAnalysisTaskFlowVectorCorrections(const
 fCalibrateByRun(kTRUE),
 fCalibrationFile(""),
 fCalibrationFileSource(CALIBSRC_local),
+fCalibrationCache(NULL),
+fCalibrationPrefetchRuns(""),
+fRunIndexedCalibration(kFALSE),
+fRunIndexedCalibrationFile(NULL),
+fBackgroundCalibrationPrefetch(kFALSE),
+fCalibrationPrefetchThread(NULL),
+fPrefetchedRun(-1),
+fPrefetchMode(PREFETCH_none),
+fPrefetchSource(),
+fPrefetchDestination(),
+fPrefetchOffset(0),
+fPrefetchLength(-1),
+fPrefetchSucceeded(kFALSE),
+fNoOfCalibrationWaits(0),
+fNoOfSynchronousCalibrationFetches(0),
+fCalibrationWaitTime(0.0),
 fTriggerMask(0),
 fEventQAList(0x0),
 fEventCuts(NULL),
 fLabel(""),
 fQAhistograms(""),
 fFillEventQA(kFALSE),
+fQATier(QATIER_full),
+fTrackQAPrescale(1),
+fTrackQASampleHist(NULL),
 fProvideQnVectorsList(kFALSE),
+fFillColumnarQnVectors(kFALSE),
+fColumnarQnVectorsFileName("QnVectorsColumnar.qncol"),
+fColumnarQnVectorsBatchSize(4096),
+fColumnarQnVectorsMaxHarmonic(4),
+fColumnarQnVectorsEventVariables(""),
+fSparseHistograms(kFALSE),
+fSparseOutputHistogramsList(NULL),
+fSparseQAHistogramsList(NULL),
+fSparseNveQAHistogramsList(NULL),
+fColumnarQnVectorsWriter(NULL),
+fColumnarQnVectorsNoOfEventVariables(0),
+fColumnarQnVectorsEventVarIds(NULL),
+fColumnarQnVectorsNoOfQnVectors(0),
+fNoOfQnVectorSubscriptions(0),
+fQnVectorSubscriptionsResolved(kFALSE),
+fSubscriptionConfiguration(),
+fSubscriptionExpectedStep(),
+fSubscriptionAlternativeStep(),
+fSubscriptionExpectedQnVector(),
+fSubscriptionAlternativeQnVector(),
+fSubscribedQnVector(),
 fOutputSlotEventQA(-1),
 fOutputSlotHistQA(-1),
 fOutputSlotHistNveQA(-1),
@@ -85,6 +183,17 @@ fOutputSlotTree(-1)
   fEventHistos = new AliQnCorrectionsHistos();
 }
 
+//_________________________________________________________________________________
+AliAnalysisTaskFlowVectorCorrections::~AliAnalysisTaskFlowVectorCorrections()
+{
+  //
+  // Destructor
+  //
+  StopCalibrationPrefetch();
+  delete fCalibrationCache;
+  delete fRunIndexedCalibrationFile;
+}
+
 //_________________________________________________________________________________
 void AliAnalysisTaskFlowVectorCorrections::DefineInOutput(){
 
@@ -138,6 +247,10 @@ void AliAnalysisTaskFlowVectorCorrections::SetCalibrationHistogramsFile(Calibrat
 
   switch (fCalibrationFileSource) {
   case CALIBSRC_local:
+    if (fRunIndexedCalibration && fCalibrateByRun) {
+      /* the run calibrations will be loaded on demand where the task executes */
+      break;
+    }
     if (fCalibrationFile.Length() != 0) {
       if(fCalibrationFile.Contains("alien"))
         TGrid::Connect("alien://");
@@ -145,7 +258,7 @@ void AliAnalysisTaskFlowVectorCorrections::SetCalibrationHistogramsFile(Calibrat
     }
     if (calibfile != NULL && calibfile->IsOpen()) {
       AliInfo(Form("\t Calibration file %s open", fCalibrationFile.Data()));
-      fAliQnCorrectionsManager->SetCalibrationHistogramsList(calibfile);
+      LoadCalibrationHistograms(calibfile);
       calibfile->Close();
     }
     else {
@@ -167,6 +280,462 @@ void AliAnalysisTaskFlowVectorCorrections::SetCalibrationHistogramsFile(Calibrat
   }
 }
 
+/// Loads on demand the run calibration from single calibration files with the run indexed layout
+///
+/// Only the file index is read when the task starts, the calibration of
+/// each run is read when the run is reached. For the local source the file
+/// is then opened where the task executes. Files without the run indexed
+/// layout are loaded at once, as usual.
+/// For the local source it has to be called before SetCalibrationHistogramsFile,
+/// which otherwise loads the whole calibration file when the task object is built.
+/// Only the calibration histograms the framework keeps for each loaded run
+/// stay in memory, the per run file read from the run indexed one is
+/// deleted once the framework has taken them.
+/// \param enable kTRUE for loading the run calibration on demand
+void AliAnalysisTaskFlowVectorCorrections::SetRunIndexedCalibration(Bool_t enable) {
+
+  if (enable && !fRunIndexedCalibration && fCalibrationFileSource == CALIBSRC_local && fCalibrationFile.Length() != 0)
+    AliWarning(Form("Run indexed calibration enabled after the local calibration file %s was already loaded. "
+        "Call SetRunIndexedCalibration before SetCalibrationHistogramsFile", fCalibrationFile.Data()));
+
+  fRunIndexedCalibration = enable;
+}
+
+/// Uses a node local cache for the per run calibration files
+///
+/// Only used for the CALIBSRC_alienmultiple and CALIBSRC_OADBmultiple sources.
+/// The per run calibration files are then looked for in the cache directory,
+/// shared by the jobs running on the same node, before going to their source.
+/// \param directory the cache directory on the execution node
+/// \param maxSize the maximum size, in bytes, of the cached files
+/// \param fetcher the cache fetch backend, the task takes ownership. NULL for the default one
+void AliAnalysisTaskFlowVectorCorrections::SetCalibrationCache(const char *directory, Long64_t maxSize, AliQnCorrectionsCalibrationFetcher *fetcher) {
+
+  delete fCalibrationCache;
+  fCalibrationCache = new AliQnCorrectionsCalibrationCache(directory, maxSize, fetcher);
+}
+
+/// Sets the runs whose calibration files are brought to the cache when the task starts
+///
+/// Usually the list of active runs. Used if the calibration cache is in use.
+/// The list order is also the run order assumed by the background calibration prefetch.
+/// \param runsList the list of runs as TObjString with the run number
+void AliAnalysisTaskFlowVectorCorrections::SetCalibrationPrefetchRuns(const TObjArray *runsList) {
+
+  fCalibrationPrefetchRuns = "";
+  for (Int_t i = 0; i < runsList->GetEntriesFast(); i++) {
+    fCalibrationPrefetchRuns += ((TObjString *) runsList->At(i))->GetString();
+    fCalibrationPrefetchRuns += ";";
+  }
+}
+
+/// Gets the source name of the per run calibration file of a run
+/// \param run the run number
+/// \return the per run calibration file source name, empty if not a per run source
+TString AliAnalysisTaskFlowVectorCorrections::GetRunCalibrationSource(Int_t run) const {
+
+  if (fCalibrationFile.Length() == 0) return TString("");
+
+  TString runCalibrationFile = fCalibrationFile;
+  runCalibrationFile.Insert(runCalibrationFile.Index(".root"), Form("_%d", run));
+
+  switch (fCalibrationFileSource) {
+  case CALIBSRC_alienmultiple:
+    return runCalibrationFile;
+  case CALIBSRC_OADBmultiple:
+    return TString(Form("%s/%s", AliAnalysisManager::GetOADBPath(), runCalibrationFile.Data()));
+  default:
+    return TString("");
+  }
+}
+
+/// Opens the per run calibration file of a run
+///
+/// The calibration cache, if in use, is asked first. If the file
+/// is not available through the cache it is opened from its source.
+/// \param run the run number
+/// \return the open file, NULL if not available
+TFile *AliAnalysisTaskFlowVectorCorrections::OpenRunCalibrationFile(Int_t run) {
+
+  TString source = GetRunCalibrationSource(run);
+  if (source.Length() == 0) return NULL;
+
+  TFile *calibfile = NULL;
+  if (fCalibrationCache != NULL) {
+    calibfile = fCalibrationCache->Open(source);
+    if (calibfile != NULL) return calibfile;
+  }
+
+  if (fCalibrationFileSource == CALIBSRC_alienmultiple)
+    TGrid::Connect("alien://");
+  return TFile::Open(source);
+}
+
+/// Brings the per run calibration files of the prefetch runs to the cache
+void AliAnalysisTaskFlowVectorCorrections::PrefetchRunCalibrationFiles() {
+
+  if (fCalibrationCache == NULL || fCalibrationPrefetchRuns.Length() == 0) return;
+
+  TObjArray sources;
+  sources.SetOwner(kTRUE);
+  TObjArray *runs = fCalibrationPrefetchRuns.Tokenize(";");
+  for (Int_t i = 0; i < runs->GetEntriesFast(); i++) {
+    TString source = GetRunCalibrationSource(((TObjString *) runs->At(i))->GetString().Atoi());
+    if (source.Length() != 0) sources.Add(new TObjString(source));
+  }
+  delete runs;
+
+  fCalibrationCache->Prefetch(&sources);
+}
+
+/// Opens a single calibration file for loading the run calibration on demand
+///
+/// Only if the run indexed calibration is enabled, the calibration is by run
+/// and the file has the run indexed layout.
+/// \param fileName the calibration file name
+/// \return kTRUE if the run calibration will be loaded on demand
+Bool_t AliAnalysisTaskFlowVectorCorrections::OpenRunIndexedCalibration(const char *fileName) {
+
+  if (!fRunIndexedCalibration || !fCalibrateByRun) return kFALSE;
+
+  delete fRunIndexedCalibrationFile;
+  fRunIndexedCalibrationFile = AliQnCorrectionsRunIndexedCalibration::Open(fileName);
+  return (fRunIndexedCalibrationFile != NULL);
+}
+
+/// Loads the calibration of a run from the run indexed single calibration file
+/// \param run the run number
+void AliAnalysisTaskFlowVectorCorrections::LoadRunIndexedCalibration(Int_t run) {
+
+  /* the run file is only needed until the framework takes the calibration histograms */
+  TFile *runfile = fRunIndexedCalibrationFile->GetRunCalibrationFile(run);
+  if (runfile != NULL) {
+    AliInfo(Form("\t Calibration for run %d loaded from the run indexed calibration file", run));
+    LoadCalibrationHistograms(runfile);
+    runfile->Close();
+    delete runfile;
+  }
+  else {
+    AliWarning(Form("CALIBRATION FOR RUN NO: %d NOT FOUND IN THE RUN INDEXED FILE. RUNNING FRAMEWORK WITHOUT CALIBRATION PARAMETERS!!!", run));
+  }
+}
+
+/// Gets the calibration of a run ready to be passed to the framework
+/// \param run the run number
+/// \return the run calibration file, to be deleted once used. NULL if not available
+TFile *AliAnalysisTaskFlowVectorCorrections::FetchRunCalibration(Int_t run) {
+
+  if (fRunIndexedCalibrationFile != NULL)
+    return fRunIndexedCalibrationFile->GetRunCalibrationFile(run);
+
+  TFile *calibfile = OpenRunCalibrationFile(run);
+  if (calibfile != NULL && !calibfile->IsOpen()) {
+    delete calibfile;
+    calibfile = NULL;
+  }
+  return calibfile;
+}
+
+/// Gets the run following a given one in the calibration prefetch runs
+/// \param run the run number
+/// \return the next run number, -1 if none
+Int_t AliAnalysisTaskFlowVectorCorrections::GetNextPrefetchRun(Int_t run) const {
+
+  Int_t nextRun = -1;
+  TObjArray *runs = fCalibrationPrefetchRuns.Tokenize(";");
+  for (Int_t i = 0; i < runs->GetEntriesFast() - 1; i++) {
+    if (((TObjString *) runs->At(i))->GetString().Atoi() == run) {
+      nextRun = ((TObjString *) runs->At(i + 1))->GetString().Atoi();
+      break;
+    }
+  }
+  delete runs;
+  return nextRun;
+}
+
+/// The calibration prefetch thread body
+///
+/// Only plain POSIX calls, no ROOT ones. What to do was decided, and the
+/// file names built, before the thread was started.
+/// \param task the task the calibration is prefetched for
+void *AliAnalysisTaskFlowVectorCorrections::CalibrationPrefetchThread(void *task) {
+
+  AliAnalysisTaskFlowVectorCorrections *qnTask = (AliAnalysisTaskFlowVectorCorrections *) task;
+
+  switch (qnTask->fPrefetchMode) {
+  case PREFETCH_read:
+    qnTask->fPrefetchSucceeded =
+        ReadAheadFile(qnTask->fPrefetchSource.Data(), qnTask->fPrefetchOffset, qnTask->fPrefetchLength);
+    break;
+  case PREFETCH_copy:
+    qnTask->fPrefetchSucceeded = CopyLocalFile(qnTask->fPrefetchSource.Data(), qnTask->fPrefetchDestination.Data());
+    break;
+  case PREFETCH_aliencopy:
+    qnTask->fPrefetchSucceeded = CopyAlienFile(qnTask->fPrefetchSource.Data(), qnTask->fPrefetchDestination.Data());
+    break;
+  default:
+    qnTask->fPrefetchSucceeded = kFALSE;
+    break;
+  }
+  return NULL;
+}
+
+/// Reads a byte range of a file, leaving it in the node page cache
+///
+/// Only plain POSIX calls, it runs on the calibration prefetch thread.
+/// \param fileName the file name
+/// \param offset the offset, in bytes, to start reading from
+/// \param length the number of bytes to read, -1 for up to the end of the file
+/// \return kTRUE if the range was read
+Bool_t AliAnalysisTaskFlowVectorCorrections::ReadAheadFile(const char *fileName, Long64_t offset, Long64_t length) {
+
+  int fd = open(fileName, O_RDONLY);
+  if (fd < 0) return kFALSE;
+
+  const Int_t bufferSize = 1048576;
+  char *buffer = new char[bufferSize];
+  Bool_t done = kFALSE;
+  Long64_t position = offset;
+  for (;;) {
+    size_t chunk = bufferSize;
+    if (!(length < 0)) {
+      if (position - offset >= length) { done = kTRUE; break; }
+      if (offset + length - position < bufferSize) chunk = offset + length - position;
+    }
+    ssize_t n = pread(fd, buffer, chunk, position);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) break;
+    if (n == 0) { done = (length < 0); break; }
+    position += n;
+  }
+  delete [] buffer;
+  close(fd);
+  return done;
+}
+
+/// Copies a local file
+///
+/// Only plain POSIX calls, it runs on the calibration prefetch thread.
+/// \param source the source file name
+/// \param destination the destination file name
+/// \return kTRUE if the file was copied
+Bool_t AliAnalysisTaskFlowVectorCorrections::CopyLocalFile(const char *source, const char *destination) {
+
+  int in = open(source, O_RDONLY);
+  if (in < 0) return kFALSE;
+  int out = open(destination, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (out < 0) {
+    close(in);
+    return kFALSE;
+  }
+
+  const Int_t bufferSize = 1048576;
+  char *buffer = new char[bufferSize];
+  Bool_t done = kFALSE;
+  for (;;) {
+    ssize_t n = read(in, buffer, bufferSize);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) break;
+    if (n == 0) { done = kTRUE; break; }
+    ssize_t written = 0;
+    while (written < n) {
+      ssize_t m = write(out, buffer + written, n - written);
+      if (m < 0 && errno == EINTR) continue;
+      if (m < 0) break;
+      written += m;
+    }
+    if (written < n) break;
+  }
+  delete [] buffer;
+  close(in);
+  if (close(out) != 0) done = kFALSE;
+  return done;
+}
+
+/// Copies an alien file to a local file with the alien_cp command
+///
+/// Only plain POSIX calls, it runs on the calibration prefetch thread.
+/// The grid credentials of the job are the ones alien_cp uses.
+/// \param source the alien source file name
+/// \param destination the destination file name
+/// \return kTRUE if the file was copied
+Bool_t AliAnalysisTaskFlowVectorCorrections::CopyAlienFile(const char *source, const char *destination) {
+
+  TString target = Form("file:%s", destination);
+  char *argv[4];
+  argv[0] = (char *) "alien_cp";
+  argv[1] = (char *) source;
+  argv[2] = (char *) target.Data();
+  argv[3] = NULL;
+
+  pid_t pid;
+  if (posix_spawnp(&pid, argv[0], NULL, NULL, argv, environ) != 0) return kFALSE;
+
+  int status = 0;
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) return kFALSE;
+  }
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return kFALSE;
+
+  struct stat fileStat;
+  return (stat(destination, &fileStat) == 0 && fileStat.st_size > 0);
+}
+
+/// Starts bringing in the background the calibration of a run
+///
+/// What the thread has to do is decided here, where the run calibration
+/// source and the node local file to fetch it to are built, so that the
+/// thread does not need ROOT. Nothing else touches the prefetch state
+/// until the thread is joined.
+/// \param run the run number
+void AliAnalysisTaskFlowVectorCorrections::StartCalibrationPrefetch(Int_t run) {
+
+  StopCalibrationPrefetch();
+
+  fPrefetchedRun = run;
+  if (fRunIndexedCalibrationFile != NULL) {
+    /* the run key of a local file is read ahead, the framework list is built when the run starts */
+    if (fRunIndexedCalibrationFile->GetRunByteRange(run, fPrefetchSource, fPrefetchOffset, fPrefetchLength))
+      fPrefetchMode = PREFETCH_read;
+  }
+  else {
+    TString source = GetRunCalibrationSource(run);
+    Bool_t alienSource = source.BeginsWith("alien://");
+    Bool_t localSource = (source.Length() != 0 && !source.Contains("://"));
+
+    if (fCalibrationCache != NULL) {
+      fPrefetchSource = fCalibrationCache->GetStoredFileName(source);
+      if (fPrefetchSource.Length() != 0)
+        fPrefetchMode = PREFETCH_read;
+      else if (alienSource || localSource) {
+        fPrefetchSource = source;
+        fPrefetchDestination = fCalibrationCache->GetTemporaryFileName(source);
+        if (fPrefetchDestination.Length() != 0) fPrefetchMode = (alienSource) ? PREFETCH_aliencopy : PREFETCH_copy;
+      }
+    }
+    else if (alienSource) {
+      fPrefetchSource = source;
+      fPrefetchDestination = Form("%s/QnCalibration_%d_%d.root", gSystem->TempDirectory(), gSystem->GetPid(), run);
+      fPrefetchMode = PREFETCH_aliencopy;
+    }
+    else if (localSource) {
+      fPrefetchSource = source;
+      fPrefetchMode = PREFETCH_read;
+    }
+  }
+
+  if (fPrefetchMode == PREFETCH_none) {
+    AliInfo(Form("The calibration for run %d cannot be brought in the background. It will be fetched when needed", run));
+    return;
+  }
+
+  TThread::Initialize();
+  fCalibrationPrefetchThread = new TThread(CalibrationPrefetchThread, (void *) this);
+  fCalibrationPrefetchThread->Run();
+  AliInfo(Form("Calibration prefetch for run %d from %s started", run, fPrefetchSource.Data()));
+}
+
+/// Gets the prefetched calibration of a run
+///
+/// Waits, if needed, for the prefetch to finish and opens what it brought.
+/// A fetched file goes first to the calibration cache, if in use. Without
+/// it the fetched file is removed once open, it is only needed while open.
+/// If the prefetch was not for the run, or it failed, the run calibration
+/// is fetched now. The whole wait, the now fetches included, is accounted.
+/// \param run the run number
+/// \return the run calibration file, to be deleted once used. NULL if not available
+TFile *AliAnalysisTaskFlowVectorCorrections::WaitForPrefetchedCalibration(Int_t run) {
+
+  TStopwatch watch;
+  watch.Start();
+
+  if (fCalibrationPrefetchThread != NULL) {
+    fCalibrationPrefetchThread->Join();
+    delete fCalibrationPrefetchThread;
+    fCalibrationPrefetchThread = NULL;
+  }
+
+  TFile *calibfile = NULL;
+  Bool_t prefetched = (fPrefetchedRun == run && fPrefetchSucceeded);
+  if (prefetched) {
+    TString fileName = fPrefetchSource;
+    if (fPrefetchMode != PREFETCH_read) {
+      fileName = (fCalibrationCache != NULL) ?
+          fCalibrationCache->StoreFetched(GetRunCalibrationSource(run), fPrefetchDestination) : fPrefetchDestination;
+    }
+
+    if (fRunIndexedCalibrationFile != NULL)
+      calibfile = FetchRunCalibration(run);
+    else if (fileName.Length() != 0) {
+      calibfile = TFile::Open(fileName);
+      if (calibfile != NULL && (!calibfile->IsOpen() || calibfile->IsZombie())) {
+        delete calibfile;
+        calibfile = NULL;
+      }
+    }
+    prefetched = (calibfile != NULL);
+  }
+
+  /* a fetched file not in the cache is not needed once open, it is removed here */
+  StopCalibrationPrefetch();
+
+  if (!prefetched) {
+    AliInfo(Form("No calibration prefetched for run %d. Fetching it now", run));
+    calibfile = FetchRunCalibration(run);
+    fNoOfSynchronousCalibrationFetches++;
+  }
+
+  watch.Stop();
+  fNoOfCalibrationWaits++;
+  fCalibrationWaitTime += watch.RealTime();
+  AliInfo(Form("Waited %.3f s for the calibration of run %d", watch.RealTime(), run));
+  return calibfile;
+}
+
+/// Loads the prefetched calibration of a run and starts the prefetch of the next one
+/// \param run the run number
+/// \return kTRUE if the run calibration was loaded
+Bool_t AliAnalysisTaskFlowVectorCorrections::LoadPrefetchedCalibration(Int_t run) {
+
+  TFile *calibfile = WaitForPrefetchedCalibration(run);
+  Bool_t loaded = (calibfile != NULL);
+  if (loaded) {
+    AliInfo(Form("\t Calibration for run %d taken from %s", run, calibfile->GetName()));
+    LoadCalibrationHistograms(calibfile);
+    calibfile->Close();
+    delete calibfile;
+  }
+  else {
+    AliWarning(Form("CALIBRATION FOR RUN NO: %d NOT FOUND. RUNNING FRAMEWORK WITHOUT CALIBRATION PARAMETERS!!!", run));
+  }
+
+  /* while this run is processed the next one is brought in */
+  Int_t nextRun = GetNextPrefetchRun(run);
+  if (nextRun >= 0) StartCalibrationPrefetch(nextRun);
+
+  return loaded;
+}
+
+/// Waits for any calibration prefetch in flight and discards its result
+///
+/// A fetched file left in its temporary place is removed.
+void AliAnalysisTaskFlowVectorCorrections::StopCalibrationPrefetch() {
+
+  if (fCalibrationPrefetchThread != NULL) {
+    fCalibrationPrefetchThread->Join();
+    delete fCalibrationPrefetchThread;
+    fCalibrationPrefetchThread = NULL;
+  }
+  if (fPrefetchDestination.Length() != 0) gSystem->Unlink(fPrefetchDestination);
+  fPrefetchMode = PREFETCH_none;
+  fPrefetchSource = "";
+  fPrefetchDestination = "";
+  fPrefetchOffset = 0;
+  fPrefetchLength = -1;
+  fPrefetchSucceeded = kFALSE;
+  fPrefetchedRun = -1;
+}
+
 //_________________________________________________________________________________
 void AliAnalysisTaskFlowVectorCorrections::UserCreateOutputObjects()
 {
@@ -177,21 +746,38 @@ void AliAnalysisTaskFlowVectorCorrections::UserCreateOutputObjects()
 
   this->SetDefaultVarNames();
   this->SetDetectors();
+  this->BuildTrackVariablesMask();
 
   TFile *calibfile = NULL;
 
   /* get the calibration file if needed */
   switch (fCalibrationFileSource) {
   case CALIBSRC_local:
+    if (fRunIndexedCalibration && fCalibrateByRun && fCalibrationFile.Length() != 0) {
+      if (fCalibrationFile.Contains("alien"))
+        TGrid::Connect("alien://");
+      if (OpenRunIndexedCalibration(fCalibrationFile)) break;
+      /* not run indexed, it was not loaded when the task object was created */
+      calibfile = TFile::Open(fCalibrationFile);
+      if (calibfile != NULL && calibfile->IsOpen()) {
+        AliInfo(Form("\t Calibration file %s open", fCalibrationFile.Data()));
+        LoadCalibrationHistograms(calibfile);
+        calibfile->Close();
+      }
+      else {
+        AliWarning("CALIBRATION FILE NOT FOUND. RUNNING FRAMEWORK WITHOUT CALIBRATION PARAMETERS!!!");
+      }
+    }
     break;
   case CALIBSRC_aliensingle:
     if (fCalibrationFile.Length() != 0) {
       TGrid::Connect("alien://");
+      if (OpenRunIndexedCalibration(fCalibrationFile)) break;
       calibfile = TFile::Open(fCalibrationFile);
     }
     if (calibfile != NULL && calibfile->IsOpen()) {
       AliInfo(Form("\t Calibration file %s open", fCalibrationFile.Data()));
-      fAliQnCorrectionsManager->SetCalibrationHistogramsList(calibfile);
+      LoadCalibrationHistograms(calibfile);
       calibfile->Close();
     }
     else {
@@ -200,14 +786,17 @@ void AliAnalysisTaskFlowVectorCorrections::UserCreateOutputObjects()
     break;
   case CALIBSRC_alienmultiple:
     /* we still don't know the run neither the calibration file */
+    PrefetchRunCalibrationFiles();
     break;
   case CALIBSRC_OADBsingle:
     if (fCalibrationFile.Length() != 0) {
-      calibfile = TFile::Open(Form("%s/COMMON/EVENTPLANE/framework_v2_data/%s", AliAnalysisManager::GetOADBPath(),fCalibrationFile.Data()));
+      TString oadbCalibrationFile = Form("%s/COMMON/EVENTPLANE/framework_v2_data/%s", AliAnalysisManager::GetOADBPath(),fCalibrationFile.Data());
+      if (OpenRunIndexedCalibration(oadbCalibrationFile)) break;
+      calibfile = TFile::Open(oadbCalibrationFile);
     }
     if (calibfile != NULL && calibfile->IsOpen()) {
       AliInfo(Form("\t Calibration file %s open", fCalibrationFile.Data()));
-      fAliQnCorrectionsManager->SetCalibrationHistogramsList(calibfile);
+      LoadCalibrationHistograms(calibfile);
       calibfile->Close();
     }
     else {
@@ -216,11 +805,21 @@ void AliAnalysisTaskFlowVectorCorrections::UserCreateOutputObjects()
     break;
   case CALIBSRC_OADBmultiple:
     /* we still don't know the run neither the calibration file */
+    PrefetchRunCalibrationFiles();
     break;
   default:
     break;
   }
 
+  /* the calibration of the first run can already be brought in */
+  if (fBackgroundCalibrationPrefetch && fCalibrationPrefetchRuns.Length() != 0 &&
+      (fRunIndexedCalibrationFile != NULL || fCalibrationFileSource == CALIBSRC_alienmultiple ||
+          fCalibrationFileSource == CALIBSRC_OADBmultiple)) {
+    TObjArray *runs = fCalibrationPrefetchRuns.Tokenize(";");
+    if (runs->GetEntriesFast() > 0) StartCalibrationPrefetch(((TObjString *) runs->At(0))->GetString().Atoi());
+    delete runs;
+  }
+
   fAliQnCorrectionsManager->InitializeQnCorrectionsFramework();
 
   if (fAliQnCorrectionsManager->GetShouldFillOutputHistograms())
@@ -231,8 +830,16 @@ void AliAnalysisTaskFlowVectorCorrections::UserCreateOutputObjects()
     PostData(fOutputSlotHistQA, fAliQnCorrectionsManager->GetQAHistogramsList());
   if (fAliQnCorrectionsManager->GetShouldFillNveQAHistograms())
     PostData(fOutputSlotHistNveQA, fAliQnCorrectionsManager->GetNveQAHistogramsList());
-  if (fFillEventQA)
+  if (fFillEventQA) {
+    /* the per track QA sample, for renormalising the per track QA histograms */
+    fTrackQASampleHist = new TH1F("TrackQASample",
+        Form("Events with per track QA (tier: %s, prescale: %d)",
+            (fQATier == QATIER_full) ? "full" : "prescaled", fTrackQAPrescale), 2, 0.0, 2.0);
+    fTrackQASampleHist->GetXaxis()->SetBinLabel(1, "Events");
+    fTrackQASampleHist->GetXaxis()->SetBinLabel(2, "Events with track QA");
+    fEventQAList->Add(fTrackQASampleHist);
     PostData(fOutputSlotEventQA, fEventQAList);
+  }
 }
 
 /// The current run has changed. Usually it is only sent before
@@ -242,24 +849,43 @@ void AliAnalysisTaskFlowVectorCorrections::NotifyRun() {
 
   AliInfo(Form("New run number: %d", this->fCurrentRunNumber));
 
+  /* the input format does not change but this is the first place the input event is available */
+  ResolveInputEventFormat();
+
+  /* the detectors geometry does not change within a run */
+  BuildRawFMDStripGeometry();
+
+  /* the forward multiplicity binning could change with the run */
+  InvalidateFMDCache();
+
+  /* as could the Qn vectors list */
+  fQnVectorSubscriptionsResolved = kFALSE;
+
   TFile *calibfile = NULL;
 
   switch (fCalibrationFileSource) {
   case CALIBSRC_local:
   case CALIBSRC_aliensingle:
+    /* the run calibration could need to be loaded */
+    if (fRunIndexedCalibrationFile != NULL) {
+      if (fBackgroundCalibrationPrefetch)
+        LoadPrefetchedCalibration(this->fCurrentRunNumber);
+      else
+        LoadRunIndexedCalibration(this->fCurrentRunNumber);
+    }
     /* we should have everyhting in place so just inform the framework in case it has to switch to the new one */
     if (fCalibrateByRun) fAliQnCorrectionsManager->SetCurrentProcessListName(Form("%d", this->fCurrentRunNumber));
     break;
   case CALIBSRC_alienmultiple:
-    if (fCalibrationFile.Length() != 0) {
-      TString runCalibrationFile = fCalibrationFile;
-      runCalibrationFile.Insert(runCalibrationFile.Index(".root"), Form("_%d", this->fCurrentRunNumber));
-      TGrid::Connect("alien://");
-      calibfile = TFile::Open(runCalibrationFile);
+    if (fBackgroundCalibrationPrefetch) {
+      if (LoadPrefetchedCalibration(this->fCurrentRunNumber) && fCalibrateByRun)
+        fAliQnCorrectionsManager->SetCurrentProcessListName(Form("%d", this->fCurrentRunNumber));
+      break;
     }
+    calibfile = OpenRunCalibrationFile(this->fCurrentRunNumber);
     if (calibfile != NULL && calibfile->IsOpen()) {
       AliInfo(Form("\t Calibration file %s open", fCalibrationFile.Data()));
-      fAliQnCorrectionsManager->SetCalibrationHistogramsList(calibfile);
+      LoadCalibrationHistograms(calibfile);
       calibfile->Close();
       if (fCalibrateByRun) fAliQnCorrectionsManager->SetCurrentProcessListName(Form("%d", this->fCurrentRunNumber));
     }
@@ -268,18 +894,26 @@ void AliAnalysisTaskFlowVectorCorrections::NotifyRun() {
     }
     break;
   case CALIBSRC_OADBsingle:
+    /* the run calibration could need to be loaded */
+    if (fRunIndexedCalibrationFile != NULL) {
+      if (fBackgroundCalibrationPrefetch)
+        LoadPrefetchedCalibration(this->fCurrentRunNumber);
+      else
+        LoadRunIndexedCalibration(this->fCurrentRunNumber);
+    }
     /* we should have everyhting in place so just inform the framework in case it has to switch to the new one */
     if (fCalibrateByRun) fAliQnCorrectionsManager->SetCurrentProcessListName(Form("%d", this->fCurrentRunNumber));
     break;
   case CALIBSRC_OADBmultiple: {
-      TString runCalibrationFile = fCalibrationFile;
-      if (fCalibrationFile.Length() != 0) {
-        runCalibrationFile.Insert(runCalibrationFile.Index(".root"), Form("_%d", this->fCurrentRunNumber));
-        calibfile = TFile::Open(Form("%s/%s", AliAnalysisManager::GetOADBPath(),runCalibrationFile.Data()));
+      if (fBackgroundCalibrationPrefetch) {
+        if (LoadPrefetchedCalibration(this->fCurrentRunNumber) && fCalibrateByRun)
+          fAliQnCorrectionsManager->SetCurrentProcessListName(Form("%d", this->fCurrentRunNumber));
+        break;
       }
+      calibfile = OpenRunCalibrationFile(this->fCurrentRunNumber);
       if (calibfile != NULL && calibfile->IsOpen()) {
-        AliInfo(Form("\t Calibration file %s open", Form("OADB/%s", runCalibrationFile.Data())));
-        fAliQnCorrectionsManager->SetCalibrationHistogramsList(calibfile);
+        AliInfo(Form("\t Calibration file %s open", calibfile->GetName()));
+        LoadCalibrationHistograms(calibfile);
         calibfile->Close();
         if (fCalibrateByRun) fAliQnCorrectionsManager->SetCurrentProcessListName(Form("%d", this->fCurrentRunNumber));
       }
@@ -300,8 +934,17 @@ void AliAnalysisTaskFlowVectorCorrections::UserExec(Option_t *){
 
   fEvent = InputEvent();
   fAliQnCorrectionsManager->ClearEvent();
+  ResetEventArena();
 
   fDataBank = fAliQnCorrectionsManager->GetDataContainer();
+  ResetUnextractedTrackVariables();
+
+  /* the heavy per track QA only for the events in the QA sample */
+  fFillTrackQA = (fQATier == QATIER_full) || IsEventInTrackQASample();
+  if (fTrackQASampleHist != NULL) {
+    fTrackQASampleHist->Fill(0.5);
+    if (fFillTrackQA) fTrackQASampleHist->Fill(1.5);
+  }
 
   FillEventData();
 
@@ -311,7 +954,12 @@ void AliAnalysisTaskFlowVectorCorrections::UserExec(Option_t *){
     fEventHistos->FillHistClass("Event_Analysis", fDataBank);
 
     fAliQnCorrectionsManager->ProcessEvent();
+
+    if (fFillColumnarQnVectors) FillColumnarQnVectors();
+    UpdateQnVectorSubscriptions(kTRUE);
   }  // end if event selection
+  else
+    UpdateQnVectorSubscriptions(kFALSE);
 
   if(fProvideQnVectorsList)
     PostData(fOutputSlotQnVectorsList, fAliQnCorrectionsManager->GetQnVectorList());
@@ -325,6 +973,22 @@ void AliAnalysisTaskFlowVectorCorrections::FinishTaskOutput()
   //
   fAliQnCorrectionsManager->FinalizeQnCorrectionsFramework();
 
+  if (fBackgroundCalibrationPrefetch) {
+    StopCalibrationPrefetch();
+    AliInfo(Form("Waited for %d run calibrations, %d of them not prefetched, %.3f s in total",
+        fNoOfCalibrationWaits, fNoOfSynchronousCalibrationFetches, fCalibrationWaitTime));
+  }
+
+  if (fColumnarQnVectorsWriter != NULL) {
+    fColumnarQnVectorsWriter->Close();
+    delete fColumnarQnVectorsWriter;
+    fColumnarQnVectorsWriter = NULL;
+    delete [] fColumnarQnVectorsEventVarIds;
+    fColumnarQnVectorsEventVarIds = NULL;
+  }
+
+  if (fSparseHistograms) PostSparseHistograms();
+
   THashList* hList = (THashList*) fEventHistos->HistList();
   for(Int_t i=0; i<hList->GetEntries(); ++i) {
     THashList* list = (THashList*)hList->At(i);
@@ -332,6 +996,265 @@ void AliAnalysisTaskFlowVectorCorrections::FinishTaskOutput()
   }
 }
 
+/// Passes the calibration histograms to the framework
+///
+/// With sparse histograms storage the sparse histograms of the file are
+/// expanded, in memory, to the dense ones the framework expects.
+/// \param calibfile the calibration histograms file
+void AliAnalysisTaskFlowVectorCorrections::LoadCalibrationHistograms(TFile *calibfile) {
+
+  TFile *densefile = NULL;
+  if (fSparseHistograms) densefile = AliQnCorrectionsSparseHistograms::CreateDenseFile(calibfile);
+
+  if (densefile != NULL) {
+    fAliQnCorrectionsManager->SetCalibrationHistogramsList(densefile);
+    densefile->Close();
+    delete densefile;
+  }
+  else
+    fAliQnCorrectionsManager->SetCalibrationHistogramsList(calibfile);
+}
+
+/// Posts sparse copies of the calibration and QA histograms lists
+///
+/// The framework keeps working with its dense histograms, only the
+/// copies which go to the output files are sparse.
+void AliAnalysisTaskFlowVectorCorrections::PostSparseHistograms() {
+
+  if (fAliQnCorrectionsManager->GetShouldFillOutputHistograms()) {
+    fSparseOutputHistogramsList =
+        AliQnCorrectionsSparseHistograms::CreateSparseCopy(fAliQnCorrectionsManager->GetOutputHistogramsList());
+    PostData(fOutputSlotHistQn, fSparseOutputHistogramsList);
+  }
+  if (fAliQnCorrectionsManager->GetShouldFillQAHistograms()) {
+    fSparseQAHistogramsList =
+        AliQnCorrectionsSparseHistograms::CreateSparseCopy(fAliQnCorrectionsManager->GetQAHistogramsList());
+    PostData(fOutputSlotHistQA, fSparseQAHistogramsList);
+  }
+  if (fAliQnCorrectionsManager->GetShouldFillNveQAHistograms()) {
+    fSparseNveQAHistogramsList =
+        AliQnCorrectionsSparseHistograms::CreateSparseCopy(fAliQnCorrectionsManager->GetNveQAHistogramsList());
+    PostData(fOutputSlotHistNveQA, fSparseNveQAHistogramsList);
+  }
+}
+
+/// Decides if the current event belongs to the per track QA sample
+///
+/// The decision only depends on the event identity, period, orbit and
+/// bunch crossing, so it is reproducible whatever the splitting of the
+/// input files among jobs and workers is.
+/// \return kTRUE if the per track QA histograms should be filled for the current event
+Bool_t AliAnalysisTaskFlowVectorCorrections::IsEventInTrackQASample() const {
+
+  if (fTrackQAPrescale < 2) return kTRUE;
+
+  ULong64_t key = GetEventIdentifier();
+
+  /* mix the bits so that the sample is not aligned with the filling scheme */
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
+
+  return (key % ULong64_t(fTrackQAPrescale)) == 0;
+}
+
+/// Builds the identifier of the current event within its run
+///
+/// The identifier packs period, orbit and bunch crossing numbers
+/// \return the event identifier
+ULong64_t AliAnalysisTaskFlowVectorCorrections::GetEventIdentifier() const {
+
+  return (ULong64_t(fEvent->GetPeriodNumber()) << 36)
+      | (ULong64_t(fEvent->GetOrbitNumber() & 0xFFFFFF) << 12)
+      | ULong64_t(fEvent->GetBunchCrossNumber() & 0xFFF);
+}
+
+/// Builds the columnar file schema out of the current Qn vectors list and opens the file
+///
+/// The columns are the run number, the event identifier, the requested event
+/// variables and, for each detector configuration and correction step, the
+/// number of contributors, the quality flag and the X and Y components of
+/// each harmonic. The Qn vectors list structure does not change once the
+/// framework is initialized so the schema is built only once.
+/// \return kTRUE if the columnar file is open
+Bool_t AliAnalysisTaskFlowVectorCorrections::OpenColumnarQnVectors() {
+
+  fColumnarQnVectorsWriter = new AliQnCorrectionsColumnarWriter();
+
+  fColumnarQnVectorsWriter->AddColumn("RunNo", AliQnCorrectionsColumnarWriter::kInt);
+  fColumnarQnVectorsWriter->AddColumn("EventId", AliQnCorrectionsColumnarWriter::kLong64);
+
+  TObjArray *tokens = fColumnarQnVectorsEventVariables.Tokenize(";");
+  fColumnarQnVectorsNoOfEventVariables = 0;
+  fColumnarQnVectorsEventVarIds = new Int_t[tokens->GetEntriesFast() + 1];
+  for (Int_t i = 0; i < tokens->GetEntriesFast(); i++) {
+    Int_t var = ((TObjString *) tokens->At(i))->GetString().Atoi();
+    if (var < 0 || !(var < kNVars)) continue;
+    TString name = VarName(var);
+    name.ReplaceAll(" ", "_");
+    fColumnarQnVectorsWriter->AddColumn(name.Data(), AliQnCorrectionsColumnarWriter::kFloat);
+    fColumnarQnVectorsEventVarIds[fColumnarQnVectorsNoOfEventVariables++] = var;
+  }
+  delete tokens;
+
+  fColumnarQnVectorsNoOfQnVectors = 0;
+  TIter nextDetectorConfiguration(fAliQnCorrectionsManager->GetQnVectorList());
+  TList *detectorConfigurationList;
+  while ((detectorConfigurationList = (TList *) nextDetectorConfiguration()) != NULL) {
+    TIter nextStep(detectorConfigurationList);
+    AliQnCorrectionsQnVector *qnVector;
+    while ((qnVector = (AliQnCorrectionsQnVector *) nextStep()) != NULL) {
+      TString prefix = Form("%s_%s", detectorConfigurationList->GetName(), qnVector->GetName());
+      fColumnarQnVectorsWriter->AddColumn(Form("%s_N", prefix.Data()), AliQnCorrectionsColumnarWriter::kInt);
+      fColumnarQnVectorsWriter->AddColumn(Form("%s_quality", prefix.Data()), AliQnCorrectionsColumnarWriter::kUChar);
+      for (Int_t h = 1; h <= fColumnarQnVectorsMaxHarmonic; h++) {
+        fColumnarQnVectorsWriter->AddColumn(Form("%s_h%d_qx", prefix.Data(), h), AliQnCorrectionsColumnarWriter::kFloat);
+        fColumnarQnVectorsWriter->AddColumn(Form("%s_h%d_qy", prefix.Data(), h), AliQnCorrectionsColumnarWriter::kFloat);
+      }
+      fColumnarQnVectorsNoOfQnVectors++;
+    }
+  }
+
+  Int_t nExpectedColumns = 2 + fColumnarQnVectorsNoOfEventVariables
+      + fColumnarQnVectorsNoOfQnVectors * (2 + 2 * fColumnarQnVectorsMaxHarmonic);
+  if (fColumnarQnVectorsWriter->GetNoOfColumns() != nExpectedColumns ||
+      !fColumnarQnVectorsWriter->Open(fColumnarQnVectorsFileName.Data(), fColumnarQnVectorsBatchSize)) {
+    AliError("The columnar Qn vectors file cannot be produced. Columnar output disabled");
+    fFillColumnarQnVectors = kFALSE;
+    return kFALSE;
+  }
+  return kTRUE;
+}
+
+/// Stores the current event Qn vectors as a new columnar file row
+void AliAnalysisTaskFlowVectorCorrections::FillColumnarQnVectors() {
+
+  if (fColumnarQnVectorsWriter == NULL)
+    if (!OpenColumnarQnVectors()) return;
+
+  fColumnarQnVectorsWriter->SetInt(0, fEvent->GetRunNumber());
+  fColumnarQnVectorsWriter->SetLong64(1, GetEventIdentifier());
+  Int_t column = 2;
+  for (Int_t i = 0; i < fColumnarQnVectorsNoOfEventVariables; i++)
+    fColumnarQnVectorsWriter->SetFloat(column++, fDataBank[fColumnarQnVectorsEventVarIds[i]]);
+
+  Int_t nQnVectors = 0;
+  TIter nextDetectorConfiguration(fAliQnCorrectionsManager->GetQnVectorList());
+  TList *detectorConfigurationList;
+  while ((detectorConfigurationList = (TList *) nextDetectorConfiguration()) != NULL) {
+    TIter nextStep(detectorConfigurationList);
+    AliQnCorrectionsQnVector *qnVector;
+    while ((qnVector = (AliQnCorrectionsQnVector *) nextStep()) != NULL) {
+      if (!(nQnVectors < fColumnarQnVectorsNoOfQnVectors)) {
+        AliFatal("The Qn vectors list structure changed. Aborting!!!");
+        return;
+      }
+      fColumnarQnVectorsWriter->SetInt(column++, qnVector->GetN());
+      fColumnarQnVectorsWriter->SetUChar(column++, qnVector->IsGoodQuality() ? 1 : 0);
+      for (Int_t h = 1; h <= fColumnarQnVectorsMaxHarmonic; h++) {
+        fColumnarQnVectorsWriter->SetFloat(column++, qnVector->Qx(h));
+        fColumnarQnVectorsWriter->SetFloat(column++, qnVector->Qy(h));
+      }
+      nQnVectors++;
+    }
+  }
+  if (nQnVectors != fColumnarQnVectorsNoOfQnVectors) {
+    AliFatal("The Qn vectors list structure changed. Aborting!!!");
+    return;
+  }
+  fColumnarQnVectorsWriter->CommitRow();
+}
+
+/// Subscribes to the Qn vector of a detector configuration
+///
+/// Consumer tasks subscribe once, usually when creating their output objects,
+/// and afterwards get the Qn vector for each event with GetSubscribedQnVector,
+/// with no need to search the Qn vectors list. The Qn vector of the expected
+/// correction step is provided if it is of good quality, otherwise the one of
+/// the alternative correction step is provided, if it is of good quality.
+/// "latest" stands for the latest correction step applied to the detector
+/// configuration. Identical subscriptions share the same id.
+/// \param detectorConfiguration the detector configuration name
+/// \param expectedStep the expected correction step name
+/// \param alternativeStep the alternative correction step name
+/// \return the subscription id
+Int_t AliAnalysisTaskFlowVectorCorrections::SubscribeQnVector(const char *detectorConfiguration, const char *expectedStep, const char *alternativeStep) {
+
+  for (Int_t i = 0; i < fNoOfQnVectorSubscriptions; i++) {
+    if (fSubscriptionConfiguration[i].EqualTo(detectorConfiguration) &&
+        fSubscriptionExpectedStep[i].EqualTo(expectedStep) &&
+        fSubscriptionAlternativeStep[i].EqualTo(alternativeStep))
+      return i;
+  }
+
+  if (!(fNoOfQnVectorSubscriptions < fMaxNoOfQnVectorSubscriptions))
+    AliFatal(Form("Too many Qn vectors subscriptions. Maximum allowed: %d", fMaxNoOfQnVectorSubscriptions));
+
+  Int_t subscription = fNoOfQnVectorSubscriptions++;
+  fSubscriptionConfiguration[subscription] = detectorConfiguration;
+  fSubscriptionExpectedStep[subscription] = expectedStep;
+  fSubscriptionAlternativeStep[subscription] = alternativeStep;
+  fSubscribedQnVector[subscription] = NULL;
+  fQnVectorSubscriptionsResolved = kFALSE;
+  return subscription;
+}
+
+/// Locates the subscribed Qn vectors in the Qn vectors list
+///
+/// The Qn vectors list structure is built when the framework is initialized
+/// so its Qn vectors are located once and not on each event.
+void AliAnalysisTaskFlowVectorCorrections::ResolveQnVectorSubscriptions() {
+
+  TList *qnVectorList = fAliQnCorrectionsManager->GetQnVectorList();
+
+  for (Int_t i = 0; i < fNoOfQnVectorSubscriptions; i++) {
+    fSubscriptionExpectedQnVector[i] = NULL;
+    fSubscriptionAlternativeQnVector[i] = NULL;
+
+    TList *detectorConfigurationList = (qnVectorList != NULL) ?
+        dynamic_cast<TList *>(qnVectorList->FindObject(fSubscriptionConfiguration[i].Data())) : NULL;
+    if (detectorConfigurationList == NULL) continue;
+
+    if (fSubscriptionExpectedStep[i].EqualTo("latest"))
+      fSubscriptionExpectedQnVector[i] = (AliQnCorrectionsQnVector *) detectorConfigurationList->First();
+    else
+      fSubscriptionExpectedQnVector[i] = (AliQnCorrectionsQnVector *) detectorConfigurationList->FindObject(fSubscriptionExpectedStep[i].Data());
+    if (fSubscriptionAlternativeStep[i].EqualTo("latest"))
+      fSubscriptionAlternativeQnVector[i] = (AliQnCorrectionsQnVector *) detectorConfigurationList->First();
+    else
+      fSubscriptionAlternativeQnVector[i] = (AliQnCorrectionsQnVector *) detectorConfigurationList->FindObject(fSubscriptionAlternativeStep[i].Data());
+  }
+  fQnVectorSubscriptionsResolved = kTRUE;
+}
+
+/// Provides the subscribed Qn vectors for the current event
+/// \param selected kTRUE if the current event was selected and processed
+void AliAnalysisTaskFlowVectorCorrections::UpdateQnVectorSubscriptions(Bool_t selected) {
+
+  if (fNoOfQnVectorSubscriptions == 0) return;
+
+  if (!selected) {
+    for (Int_t i = 0; i < fNoOfQnVectorSubscriptions; i++)
+      fSubscribedQnVector[i] = NULL;
+    return;
+  }
+
+  if (!fQnVectorSubscriptionsResolved) ResolveQnVectorSubscriptions();
+
+  for (Int_t i = 0; i < fNoOfQnVectorSubscriptions; i++) {
+    const AliQnCorrectionsQnVector *qnVector = fSubscriptionExpectedQnVector[i];
+    if (qnVector == NULL || !(qnVector->IsGoodQuality()) || !(qnVector->GetN() != 0))
+      /* the Qn vector for the expected step is not usable */
+      qnVector = fSubscriptionAlternativeQnVector[i];
+    if (qnVector != NULL && (!(qnVector->IsGoodQuality()) || !(qnVector->GetN() != 0)))
+      /* not good quality, discarded */
+      qnVector = NULL;
+    fSubscribedQnVector[i] = qnVector;
+  }
+}
+
 Bool_t AliAnalysisTaskFlowVectorCorrections::IsEventSelected(Float_t* values) {
 
   if(!fEventCuts) return kTRUE;
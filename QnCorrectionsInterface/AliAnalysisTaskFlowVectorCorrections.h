@@ -22,6 +22,13 @@
 class AliQnCorrectionsManager;
 class AliQnCorrectionsCutsSet;
 class AliQnCorrectionsHistos;
+class AliQnCorrectionsColumnarWriter;
+class AliQnCorrectionsCalibrationCache;
+class AliQnCorrectionsCalibrationFetcher;
+class AliQnCorrectionsRunIndexedCalibration;
+class AliQnCorrectionsQnVector;
+class TH1F;
+class TThread;
 
 class AliAnalysisTaskFlowVectorCorrections : public AliQnCorrectionsFillEventTask {
 
@@ -36,10 +43,17 @@ public:
     CALIBSRC_OADBmultiple,  ///< run calibration file, which contains correction parameters only for the intended run, will be taken from OADB on each execution node
   };
 
+  /// \enum QATier
+  /// \brief The supported QA histograms filling tiers
+  enum QATier {
+    QATIER_full,        ///< all QA histogram classes are filled for every event
+    QATIER_prescaled    ///< the per track QA histogram classes are only filled for a prescaled subset of events
+  };
+
 
   AliAnalysisTaskFlowVectorCorrections();
   AliAnalysisTaskFlowVectorCorrections(const char *name);
-  virtual ~AliAnalysisTaskFlowVectorCorrections(){}
+  virtual ~AliAnalysisTaskFlowVectorCorrections();
 
 
   virtual void UserExec(Option_t *);
@@ -53,11 +67,41 @@ public:
   void SetEventCuts(AliQnCorrectionsCutsSet *cuts)  {fEventCuts = cuts;}
   void SetFillExchangeContainerWithQvectors(Bool_t enable = kTRUE) { fProvideQnVectorsList = enable; }
   void SetFillEventQA(Bool_t enable = kTRUE) { fFillEventQA = enable; }
+  void SetQATier(QATier tier, Int_t trackQAPrescale = 1)
+    { fQATier = tier; fTrackQAPrescale = (trackQAPrescale < 1) ? 1 : trackQAPrescale; }
+  void SetFillColumnarQnVectors(Bool_t enable = kTRUE, const char *filename = "QnVectorsColumnar.qncol")
+    { fFillColumnarQnVectors = enable; fColumnarQnVectorsFileName = filename; }
+  /// Stores the dense multidimensional calibration and QA histograms as sparse ones
+  ///
+  /// Every dense histogram is stored as sparse, whatever its content, so
+  /// the outputs of all the jobs have the same layout and merge.
+  /// Sparse calibration histograms are expanded back when loaded so it has to
+  /// be set before setting the calibration histograms file.
+  /// \param enable kTRUE for sparse storage
+  void SetSparseHistogramsStorage(Bool_t enable = kTRUE) { fSparseHistograms = enable; }
+  void SetColumnarQnVectorsBatchSize(Int_t size) { fColumnarQnVectorsBatchSize = size; }
+  void SetColumnarQnVectorsMaxHarmonic(Int_t harmonic) { fColumnarQnVectorsMaxHarmonic = harmonic; }
+  void AddColumnarQnVectorsEventVariable(Int_t var) { fColumnarQnVectorsEventVariables += var; fColumnarQnVectorsEventVariables += ";"; }
   void SetTrigger(UInt_t triggerbit) {fTriggerMask=triggerbit;}
   void AddHistogramClass(TString hist) {fQAhistograms+=hist+";";}
   void SetCalibrationHistogramsFile(CalibrationFileSource source, const char *filename);
+  void SetCalibrationCache(const char *directory, Long64_t maxSize = 2000000000, AliQnCorrectionsCalibrationFetcher *fetcher = NULL);
+  void SetCalibrationPrefetchRuns(const TObjArray *runsList);
+  void SetRunIndexedCalibration(Bool_t enable = kTRUE);
+  /// Brings in the background the calibration of the next run while the current one is processed
+  ///
+  /// The next run is the one following the current one in the calibration
+  /// prefetch runs. Its per run file is fetched by a worker thread, with
+  /// alien_cp for the alien sources and by copying it for the local ones,
+  /// to the calibration cache if in use or to a node local temporary file
+  /// otherwise. Files already node local, the cached ones or the OADB ones
+  /// without cache, and the run calibration of local run indexed files, are
+  /// read ahead into the node page cache. Run indexed files not local, or
+  /// sources other than alien, are read when the run starts.
+  /// \param enable kTRUE for the background calibration prefetch
+  void SetBackgroundCalibrationPrefetch(Bool_t enable = kTRUE) { fBackgroundCalibrationPrefetch = enable; }
   void DefineInOutput();
-  void SetRunsLabels(TObjArray *runsList) { fAliQnCorrectionsManager->SetListOfProcessesNames(runsList); }
+  void SetRunsLabels(TObjArray *runsList) { fAliQnCorrectionsManager->SetListOfProcessesNames(runsList); SetRunsList(runsList); }
 
   AliQnCorrectionsManager *GetAliQnCorrectionsManager() {return fAliQnCorrectionsManager;}
   AliQnCorrectionsHistos* GetEventHistograms() {return fEventHistos;}
@@ -69,20 +113,106 @@ public:
   Int_t OutputSlotGetListQnVectors() const {return fOutputSlotQnVectorsList;}
   Int_t OutputSlotTree()          const {return fOutputSlotTree;}
   Bool_t IsEventSelected(Float_t* values);
+  Bool_t IsEventInTrackQASample() const;
+  ULong64_t GetEventIdentifier() const;
   Bool_t GetFillExchangeContainerWithQvectors() const  {return fProvideQnVectorsList;}
   Bool_t GetFillEventQA() const  {return fFillEventQA;}
+  Bool_t GetFillColumnarQnVectors() const  {return fFillColumnarQnVectors;}
+  Bool_t GetSparseHistogramsStorage() const  {return fSparseHistograms;}
+
+  /* Qn vectors subscription by consumer tasks */
+  Int_t SubscribeQnVector(const char *detectorConfiguration, const char *expectedStep = "latest", const char *alternativeStep = "latest");
+  /// Gets the Qn vector of a subscription for the current event
+  /// \param subscription the subscription id as returned by SubscribeQnVector
+  /// \return the Qn vector, NULL if not available or not of good quality for the current event
+  const AliQnCorrectionsQnVector *GetSubscribedQnVector(Int_t subscription) const { return fSubscribedQnVector[subscription]; }
+  const char *GetColumnarQnVectorsFileName() const  {return fColumnarQnVectorsFileName.Data();}
+
+private:
+  /// \enum CalibrationPrefetchMode
+  /// \brief What the calibration prefetch thread does
+  enum CalibrationPrefetchMode {
+    PREFETCH_none,        ///< nothing, the run calibration is fetched when needed
+    PREFETCH_read,        ///< reads a node local file ahead into the page cache
+    PREFETCH_copy,        ///< copies a local file to a node local file
+    PREFETCH_aliencopy    ///< copies an alien file to a node local file
+  };
+
+  void LoadCalibrationHistograms(TFile *calibfile);
+  TString GetRunCalibrationSource(Int_t run) const;
+  TFile *OpenRunCalibrationFile(Int_t run);
+  void PrefetchRunCalibrationFiles();
+  Bool_t OpenRunIndexedCalibration(const char *fileName);
+  void LoadRunIndexedCalibration(Int_t run);
+  TFile *FetchRunCalibration(Int_t run);
+  Int_t GetNextPrefetchRun(Int_t run) const;
+  void StartCalibrationPrefetch(Int_t run);
+  TFile *WaitForPrefetchedCalibration(Int_t run);
+  Bool_t LoadPrefetchedCalibration(Int_t run);
+  void StopCalibrationPrefetch();
+  static void *CalibrationPrefetchThread(void *task);
+  static Bool_t ReadAheadFile(const char *fileName, Long64_t offset, Long64_t length);
+  static Bool_t CopyLocalFile(const char *source, const char *destination);
+  static Bool_t CopyAlienFile(const char *source, const char *destination);
+  void PostSparseHistograms();
+  Bool_t OpenColumnarQnVectors();
+  void FillColumnarQnVectors();
+  void ResolveQnVectorSubscriptions();
+  void UpdateQnVectorSubscriptions(Bool_t selected);
 
 private:
   Bool_t fCalibrateByRun;
   TString fCalibrationFile;                       ///< the name of the calibration file
   CalibrationFileSource fCalibrationFileSource;   ///< the source of the calibration file
+  AliQnCorrectionsCalibrationCache *fCalibrationCache; ///< the node local per run calibration files cache, NULL if not used
+  TString fCalibrationPrefetchRuns;               ///< the runs whose calibration files are prefetched into the cache
+  Bool_t fRunIndexedCalibration;                  ///< load on demand the run calibration from run indexed single calibration files
+  AliQnCorrectionsRunIndexedCalibration *fRunIndexedCalibrationFile; //!<! the run indexed single calibration file, NULL if not used. Transient!
+  Bool_t fBackgroundCalibrationPrefetch;          ///< bring in the background the calibration of the next run
+  TThread *fCalibrationPrefetchThread;            //!<! the calibration prefetch thread, NULL if none in flight. Transient!
+  Int_t fPrefetchedRun;                           //!<! the run of the prefetched calibration, -1 if none. Transient!
+  Int_t fPrefetchMode;                            //!<! what the prefetch thread does, a CalibrationPrefetchMode. Transient!
+  TString fPrefetchSource;                        //!<! the file the prefetch thread reads or copies. Transient!
+  TString fPrefetchDestination;                   //!<! the node local file the prefetch thread copies to, empty if none. Transient!
+  Long64_t fPrefetchOffset;                       //!<! the offset, in bytes, the prefetch thread reads from. Transient!
+  Long64_t fPrefetchLength;                       //!<! the length, in bytes, the prefetch thread reads, -1 for up to the end. Transient!
+  Bool_t fPrefetchSucceeded;                      //!<! the prefetch thread did its job. Transient!
+  Int_t fNoOfCalibrationWaits;                    //!<! the number of run calibrations waited for. Transient!
+  Int_t fNoOfSynchronousCalibrationFetches;       //!<! the number of run calibrations not prefetched. Transient!
+  Double_t fCalibrationWaitTime;                  //!<! the accumulated wall time waiting for the run calibrations. Transient!
   UInt_t fTriggerMask;
   TList* fEventQAList;
   AliQnCorrectionsCutsSet *fEventCuts;
   TString fLabel;
   TString fQAhistograms;
   Bool_t fFillEventQA;
+  QATier fQATier;                                 ///< the QA histograms filling tier
+  Int_t fTrackQAPrescale;                         ///< the per track QA prescale factor for the prescaled tier
+  TH1F *fTrackQASampleHist;                       //!<! the number of events and of events with per track QA. Transient!
   Bool_t fProvideQnVectorsList;
+  Bool_t fFillColumnarQnVectors;                  ///< write the Qn vectors to a columnar file
+  TString fColumnarQnVectorsFileName;             ///< the columnar Qn vectors file name
+  Int_t fColumnarQnVectorsBatchSize;              ///< the number of events of a columnar file record batch
+  Int_t fColumnarQnVectorsMaxHarmonic;            ///< the Qn vectors harmonics up to this one go to the columnar file
+  TString fColumnarQnVectorsEventVariables;       ///< the event variables which go to the columnar file
+  Bool_t fSparseHistograms;                       ///< store the calibration and QA histograms as sparse ones
+  TList *fSparseOutputHistogramsList;             //!<! the sparse copy of the calibration histograms. Transient!
+  TList *fSparseQAHistogramsList;                 //!<! the sparse copy of the QA histograms. Transient!
+  TList *fSparseNveQAHistogramsList;              //!<! the sparse copy of the non validated entries QA histograms. Transient!
+  AliQnCorrectionsColumnarWriter *fColumnarQnVectorsWriter; //!<! the columnar Qn vectors writer. Transient!
+  Int_t fColumnarQnVectorsNoOfEventVariables;     //!<! the number of event variables in the columnar file. Transient!
+  Int_t *fColumnarQnVectorsEventVarIds;           //!<! the event variables in the columnar file. Transient!
+  Int_t fColumnarQnVectorsNoOfQnVectors;          //!<! the number of Qn vectors per event in the columnar file. Transient!
+
+  static const Int_t fMaxNoOfQnVectorSubscriptions = 64; ///< the maximum number of Qn vectors subscriptions
+  Int_t fNoOfQnVectorSubscriptions;               //!<! the number of Qn vectors subscriptions. Transient!
+  Bool_t fQnVectorSubscriptionsResolved;          //!<! the subscribed Qn vectors are located in the Qn vectors list. Transient!
+  TString fSubscriptionConfiguration[fMaxNoOfQnVectorSubscriptions];    //!<! the detector configuration of each subscription. Transient!
+  TString fSubscriptionExpectedStep[fMaxNoOfQnVectorSubscriptions];     //!<! the expected correction step of each subscription. Transient!
+  TString fSubscriptionAlternativeStep[fMaxNoOfQnVectorSubscriptions];  //!<! the alternative correction step of each subscription. Transient!
+  const AliQnCorrectionsQnVector *fSubscriptionExpectedQnVector[fMaxNoOfQnVectorSubscriptions];    //!<! the expected step Qn vector of each subscription. Transient!
+  const AliQnCorrectionsQnVector *fSubscriptionAlternativeQnVector[fMaxNoOfQnVectorSubscriptions]; //!<! the alternative step Qn vector of each subscription. Transient!
+  const AliQnCorrectionsQnVector *fSubscribedQnVector[fMaxNoOfQnVectorSubscriptions];   //!<! the current event Qn vector of each subscription. Transient!
   Int_t fOutputSlotEventQA;
   Int_t fOutputSlotHistQA;
   Int_t fOutputSlotHistNveQA;
@@ -93,7 +223,7 @@ private:
   AliAnalysisTaskFlowVectorCorrections(const AliAnalysisTaskFlowVectorCorrections &c);
   AliAnalysisTaskFlowVectorCorrections& operator= (const AliAnalysisTaskFlowVectorCorrections &c);
 
-  ClassDef(AliAnalysisTaskFlowVectorCorrections, 4);
+  ClassDef(AliAnalysisTaskFlowVectorCorrections, 13);
 };
 
 #endif // ALIANALYSISTASKFLOWVECTORCORRECTION_H
@@ -21,6 +21,9 @@ Instructions in AddTask_EPcorrectionsExample.C
 #include <AliCentrality.h>
 #include <AliESDEvent.h>
 #include <TList.h>
+#include <TMath.h>
+#include <TProfile.h>
+#include <TProfile2D.h>
 #include <TGraphErrors.h>
 #include <AliLog.h>
 #include "AliQnCorrectionsCutsSet.h"
@@ -29,6 +32,7 @@ Instructions in AddTask_EPcorrectionsExample.C
 #include "AliAnalysisTaskQnVectorAnalysis.h"
 #include "AliQnCorrectionsQnVector.h"
 #include "AliAnalysisTaskFlowVectorCorrections.h"
+#include "AliQnCorrectionsProfileAccumulator.h"
 
 // make a change
 
@@ -50,13 +54,28 @@ AliAnalysisTaskQnVectorAnalysis::AliAnalysisTaskQnVectorAnalysis() :
   fEventQAList(0x0),
   fEventCuts(NULL),
   fEventPlaneHistos(0x0),
-  fVn(),
-  fNDetectorResolutions(0),
-  fDetectorResolution(),
-  fDetectorResolutionContributors(),
-  fDetectorResolutionCorrelations(),
+  fNoOfTrackDetectors(0),
+  fTrackDetectorName(),
   fTrackDetectorNameInFile(),
+  fNoOfEPDetectors(0),
+  fEPDetectorName(),
   fEPDetectorNameInFile(),
+  fNoOfHarmonics(0),
+  fHarmonic(),
+  fNDetectorResolutions(0),
+  fDetectorResolutionContributors(),
+  fNoOfSubsamples(0),
+  fVn(NULL),
+  fDetectorResolutionCorrelations(NULL),
+  fVnSubsamples(NULL),
+  fDetectorResolutionCorrelationsSubsamples(NULL),
+  fFlowQnVectorTask(NULL),
+  fTrackDetectorQnVectorSubscription(),
+  fEPDetectorQnVectorSubscription(),
+  fVnAccumulator(NULL),
+  fCorrelationsAccumulator(NULL),
+  fVnSubsamplesAccumulator(NULL),
+  fCorrelationsSubsamplesAccumulator(NULL),
   fCentralityVariable(-1),
   fExpectedCorrectionPass("rec"),
   fAlternativeCorrectionPass("rec")
@@ -72,13 +91,28 @@ AliAnalysisTaskQnVectorAnalysis::AliAnalysisTaskQnVectorAnalysis(const char* nam
   fEventQAList(0x0),
   fEventCuts(0x0),
   fEventPlaneHistos(0x0),
-  fVn(),
-  fNDetectorResolutions(0),
-  fDetectorResolution(),
-  fDetectorResolutionContributors(),
-  fDetectorResolutionCorrelations(),
+  fNoOfTrackDetectors(0),
+  fTrackDetectorName(),
   fTrackDetectorNameInFile(),
+  fNoOfEPDetectors(0),
+  fEPDetectorName(),
   fEPDetectorNameInFile(),
+  fNoOfHarmonics(0),
+  fHarmonic(),
+  fNDetectorResolutions(0),
+  fDetectorResolutionContributors(),
+  fNoOfSubsamples(0),
+  fVn(NULL),
+  fDetectorResolutionCorrelations(NULL),
+  fVnSubsamples(NULL),
+  fDetectorResolutionCorrelationsSubsamples(NULL),
+  fFlowQnVectorTask(NULL),
+  fTrackDetectorQnVectorSubscription(),
+  fEPDetectorQnVectorSubscription(),
+  fVnAccumulator(NULL),
+  fCorrelationsAccumulator(NULL),
+  fVnSubsamplesAccumulator(NULL),
+  fCorrelationsSubsamplesAccumulator(NULL),
   fCentralityVariable(-1),
   fExpectedCorrectionPass("rec"),
   fAlternativeCorrectionPass("rec")
@@ -93,179 +127,295 @@ AliAnalysisTaskQnVectorAnalysis::AliAnalysisTaskQnVectorAnalysis(const char* nam
 
   fEventPlaneHistos = new AliQnCorrectionsHistos();
 
-  /* initialize TProfile storage */
-  for(Int_t i=0; i < nTrackDetectors*nEPDetectors; i++) {
-    for(Int_t j=0; j < kNharmonics; j++) {
-      for(Int_t k=0; k < kNcorrelationComponents; k++) {
-        fVn[i][j][k]=NULL;
-      }
+  DefineInput(0,TChain::Class());
+  DefineInput(1,TList::Class());
+  DefineOutput(1, TList::Class());// Event QA histograms
+}
+
+AliAnalysisTaskQnVectorAnalysis::~AliAnalysisTaskQnVectorAnalysis() {
+  /* clean up everything before leaving */
+  delete fVnAccumulator;
+  delete fCorrelationsAccumulator;
+  if (fVn != NULL) {
+    for (Int_t i = 0; i < fNoOfTrackDetectors*fNoOfEPDetectors*fNoOfHarmonics*kNcorrelationComponents; i++) {
+      delete fVn[i];
     }
+    delete [] fVn;
   }
-
-  for (Int_t i=0; i < nTrackDetectors*nEPDetectors; i++) {
-    for (Int_t j = 0; j < kNresolutionComponents; j++) {
-      fDetectorResolutionContributors[i][j] = -1;
+  if (fDetectorResolutionCorrelations != NULL) {
+    for (Int_t i = 0; i < fNDetectorResolutions*nCorrelationPerDetector*fNoOfHarmonics; i++) {
+      delete fDetectorResolutionCorrelations[i];
     }
-    for (Int_t iCorr = 0; iCorr < nCorrelationPerDetector; iCorr++) {
-      for(Int_t h=0; h < kNharmonics; h++) {
-        fDetectorResolutionCorrelations[i][iCorr][h] = NULL;
-      }
+    delete [] fDetectorResolutionCorrelations;
+  }
+  delete fVnSubsamplesAccumulator;
+  delete fCorrelationsSubsamplesAccumulator;
+  if (fVnSubsamples != NULL) {
+    for (Int_t i = 0; i < fNoOfTrackDetectors*fNoOfEPDetectors*fNoOfHarmonics*kNcorrelationComponents; i++) {
+      delete fVnSubsamples[i];
     }
-    for(Int_t h=0; h < kNharmonics; h++) {
-      fDetectorResolution[i][h] = NULL;
+    delete [] fVnSubsamples;
+  }
+  if (fDetectorResolutionCorrelationsSubsamples != NULL) {
+    for (Int_t i = 0; i < fNDetectorResolutions*nCorrelationPerDetector*fNoOfHarmonics; i++) {
+      delete fDetectorResolutionCorrelationsSubsamples[i];
     }
+    delete [] fDetectorResolutionCorrelationsSubsamples;
+  }
+}
+
+/// Adds a track detector to the analysis
+///
+/// The Vn profiles are built for every track detector and EP detector combination.
+/// \param name the detector name for the output profiles
+/// \param nameInList the detector configuration name in the Qn vectors list
+void AliAnalysisTaskQnVectorAnalysis::AddTrackDetector(const char *name, const char *nameInList) {
+  if (!(fNoOfTrackDetectors < fMaxNoOfDetectors)) {
+    AliError(Form("Too many track detectors. Maximum allowed: %d. Detector %s ignored", fMaxNoOfDetectors, name));
+    return;
+  }
+  fTrackDetectorName[fNoOfTrackDetectors] = name;
+  fTrackDetectorNameInFile[fNoOfTrackDetectors] = nameInList;
+  fNoOfTrackDetectors++;
+}
+
+/// Adds an EP detector to the analysis
+/// \param name the detector name for the output profiles
+/// \param nameInList the detector configuration name in the Qn vectors list
+void AliAnalysisTaskQnVectorAnalysis::AddEPDetector(const char *name, const char *nameInList) {
+  if (!(fNoOfEPDetectors < fMaxNoOfDetectors)) {
+    AliError(Form("Too many EP detectors. Maximum allowed: %d. Detector %s ignored", fMaxNoOfDetectors, name));
+    return;
+  }
+  fEPDetectorName[fNoOfEPDetectors] = name;
+  fEPDetectorNameInFile[fNoOfEPDetectors] = nameInList;
+  fNoOfEPDetectors++;
+}
+
+/// Adds a harmonic to the analysis
+/// \param harmonic the harmonic number
+void AliAnalysisTaskQnVectorAnalysis::AddHarmonic(Int_t harmonic) {
+  if (!(fNoOfHarmonics < fMaxNoOfHarmonics)) {
+    AliError(Form("Too many harmonics. Maximum allowed: %d. Harmonic %d ignored", fMaxNoOfHarmonics, harmonic));
+    return;
+  }
+  fHarmonic[fNoOfHarmonics++] = harmonic;
+}
+
+/// Adds a detector resolution triplet, for the 3-(sub-event)detector method
+///
+/// The detectors have to be added before.
+/// \param trackDetector the track detector name
+/// \param epDetectorB the first EP detector name
+/// \param epDetectorC the second EP detector name
+void AliAnalysisTaskQnVectorAnalysis::AddResolutionTriplet(const char *trackDetector, const char *epDetectorB, const char *epDetectorC) {
+  if (!(fNDetectorResolutions < fMaxNoOfResolutionTriplets)) {
+    AliError(Form("Too many detector resolution triplets. Maximum allowed: %d", fMaxNoOfResolutionTriplets));
+    return;
   }
+  Int_t a = FindDetector(fTrackDetectorName, fNoOfTrackDetectors, trackDetector);
+  Int_t b = FindDetector(fEPDetectorName, fNoOfEPDetectors, epDetectorB);
+  Int_t c = FindDetector(fEPDetectorName, fNoOfEPDetectors, epDetectorC);
+  if (a < 0 || b < 0 || c < 0) {
+    AliError(Form("Detector resolution triplet %s, %s, %s with detectors not added. Ignored", trackDetector, epDetectorB, epDetectorC));
+    return;
+  }
+  fDetectorResolutionContributors[fNDetectorResolutions][0] = a;
+  fDetectorResolutionContributors[fNDetectorResolutions][1] = b;
+  fDetectorResolutionContributors[fNDetectorResolutions][2] = c;
+  fNDetectorResolutions++;
+}
+
+/// Finds a detector by its name
+/// \param names the detectors names
+/// \param nDetectors the number of detectors
+/// \param name the name of the detector to find
+/// \return the detector index, -1 if not found
+Int_t AliAnalysisTaskQnVectorAnalysis::FindDetector(const TString *names, Int_t nDetectors, const char *name) const {
+  for (Int_t i = 0; i < nDetectors; i++) {
+    if (names[i].EqualTo(name)) return i;
+  }
+  return -1;
+}
 
-  /* the index in the input TList structure for the data of the different detectors */
-  fTrackDetectorNameInFile[kTPC] = "TPC";
-  fTrackDetectorNameInFile[kSPD] = "SPD";
-  fEPDetectorNameInFile[kVZEROA] = "VZEROA";
-  fEPDetectorNameInFile[kVZEROC] = "VZEROC";
-  fEPDetectorNameInFile[kTZEROA] = "TZEROA";
-  fEPDetectorNameInFile[kTZEROC] = "TZEROC";
-  fEPDetectorNameInFile[kFMDA] = "FMDA";
-  fEPDetectorNameInFile[kFMDC] = "FMDC";
-//  fEPDetectorNameInFile[kRawFMDA] = "FMDAraw";
-//  fEPDetectorNameInFile[kRawFMDC] = "FMDCraw";
-
-  /* the detector resolution configurations */
-  /* this is only valid in C++11
-  fDetectorResolutionContributors = {
-      {kTPC,kVZEROC,kVZEROA},
-      {kTPC,kFMDA,kFMDC},
-      {kSPD,kVZEROC,kVZEROA},
-      {kSPD,kFMDA,kFMDC}
-  }; */
-  /* for the time being we do it in this awful way */
-  const Int_t nDetectorResolutions = 10;
-  fNDetectorResolutions = nDetectorResolutions;
-  Int_t config[nDetectorResolutions][kNresolutionComponents] = {
-      {kTPC,kVZEROC,kVZEROA},
-      {kTPC,kTZEROC,kTZEROA},
-      {kTPC,kFMDA,kFMDC},
-//      {kTPC,kRawFMDA,kRawFMDC},
-      {kTPC,kVZEROC,kTZEROA},
-      {kTPC,kTZEROC,kVZEROA},
-      {kSPD,kVZEROC,kVZEROA},
-      {kSPD,kTZEROC,kTZEROA},
-      {kSPD,kFMDA,kFMDC},
-//      {kSPD,kRawFMDA,kRawFMDC},
-      {kSPD,kVZEROC,kTZEROA},
-      {kSPD,kTZEROC,kVZEROA},
-  };
-  for (Int_t ixConfig = 0; ixConfig < fNDetectorResolutions; ixConfig++) {
-    for (Int_t i = 0; i < kNresolutionComponents; i++) {
-      fDetectorResolutionContributors[ixConfig][i] = config[ixConfig][i];
+/// Builds the name of a Vn profile
+/// \param trkDetector the track detector
+/// \param epDetector the EP detector
+/// \param h the harmonic index
+/// \param component the correlation component
+/// \return the profile name
+TString AliAnalysisTaskQnVectorAnalysis::VnProfileName(Int_t trkDetector, Int_t epDetector, Int_t h, Int_t component) const {
+  return TString(Form("vn_%sx%s_%s_h%d", fTrackDetectorName[trkDetector].Data(), fEPDetectorName[epDetector].Data(),
+      namesQnComponents[component].Data(), fHarmonic[h]));
+}
+
+/// Builds the name of a detector resolution correlation profile
+/// \param triplet the detector resolution triplet
+/// \param correlation the sub-event correlation
+/// \param h the harmonic index
+/// \return the profile name
+TString AliAnalysisTaskQnVectorAnalysis::CorrelationProfileName(Int_t triplet, Int_t correlation, Int_t h) const {
+  const TString &detectorA = fTrackDetectorName[fDetectorResolutionContributors[triplet][0]];
+  const TString &detectorB = fEPDetectorName[fDetectorResolutionContributors[triplet][1]];
+  const TString &detectorC = fEPDetectorName[fDetectorResolutionContributors[triplet][2]];
+  const TString *detectorOne = &detectorA;
+  const TString *detectorTwo = &detectorB;
+  switch (correlation) {
+  case kABXX:
+  case kABYY:
+    break;
+  case kACXX:
+  case kACYY:
+    detectorTwo = &detectorC;
+    break;
+  case kBCXX:
+  case kBCYY:
+    detectorOne = &detectorB;
+    detectorTwo = &detectorC;
+    break;
+  }
+  return TString(Form("corr_%s%d_%sx%s_%s_h%d",
+      detectorA.Data(),
+      triplet,
+      detectorOne->Data(),
+      detectorTwo->Data(),
+      namesQnComponents[(correlation % 2 == 0) ? kXX : kYY].Data(),
+      fHarmonic[h]));
+}
+
+/// Sets the default configuration for what has not been configured
+///
+/// Two track detectors, six EP detectors, the first four harmonics and
+/// ten detector resolution triplets.
+void AliAnalysisTaskQnVectorAnalysis::SetDefaultConfiguration() {
+
+  if (fNoOfTrackDetectors == 0 && fNoOfEPDetectors == 0) {
+    /* the index in the input TList structure for the data of the different detectors */
+    const char *trackDetectorNameInFile[nTrackDetectors] = {"TPC","SPD"};
+    const char *epDetectorNameInFile[nEPDetectors] = {"VZEROA","VZEROC","TZEROA","TZEROC","FMDA","FMDC"/*,"FMDAraw","FMDCraw"*/};
+    for (Int_t i = 0; i < nTrackDetectors; i++) AddTrackDetector(namesQnTrackDetectors[i].Data(), trackDetectorNameInFile[i]);
+    for (Int_t i = 0; i < nEPDetectors; i++) AddEPDetector(namesQnEPDetectors[i].Data(), epDetectorNameInFile[i]);
+
+    if (fNDetectorResolutions == 0) {
+      /* the detector resolution configurations */
+      const Int_t nDetectorResolutions = 10;
+      Int_t config[nDetectorResolutions][kNresolutionComponents] = {
+          {kTPC,kVZEROC,kVZEROA},
+          {kTPC,kTZEROC,kTZEROA},
+          {kTPC,kFMDA,kFMDC},
+//          {kTPC,kRawFMDA,kRawFMDC},
+          {kTPC,kVZEROC,kTZEROA},
+          {kTPC,kTZEROC,kVZEROA},
+          {kSPD,kVZEROC,kVZEROA},
+          {kSPD,kTZEROC,kTZEROA},
+          {kSPD,kFMDA,kFMDC},
+//          {kSPD,kRawFMDA,kRawFMDC},
+          {kSPD,kVZEROC,kTZEROA},
+          {kSPD,kTZEROC,kVZEROA},
+      };
+      for (Int_t ixConfig = 0; ixConfig < nDetectorResolutions; ixConfig++) {
+        for (Int_t i = 0; i < kNresolutionComponents; i++) {
+          fDetectorResolutionContributors[ixConfig][i] = config[ixConfig][i];
+        }
+      }
+      fNDetectorResolutions = nDetectorResolutions;
     }
   }
 
+  if (fNoOfHarmonics == 0) {
+    for (Int_t h = 0; h < kNharmonics; h++) AddHarmonic(h+1);
+  }
+}
+
+/// Creates the profiles for the configured combinations only
+void AliAnalysisTaskQnVectorAnalysis::CreateProfiles() {
+
   /* create the needed TProfile for each of the track-EP detector combination
    * and for each of the v_n and for the different correlation namesQnComponents */
-  for(Int_t iTrkDetector=0; iTrkDetector < nTrackDetectors; iTrkDetector++) {
-    for (Int_t iEPDetector=0; iEPDetector < nEPDetectors; iEPDetector++) {
-      for(Int_t h=0; h<kNharmonics; h++) {
+  fVn = new TProfile*[fNoOfTrackDetectors*fNoOfEPDetectors*fNoOfHarmonics*kNcorrelationComponents];
+  for(Int_t iTrkDetector=0; iTrkDetector < fNoOfTrackDetectors; iTrkDetector++) {
+    for (Int_t iEPDetector=0; iEPDetector < fNoOfEPDetectors; iEPDetector++) {
+      for(Int_t h=0; h<fNoOfHarmonics; h++) {
         for(Int_t corrComp =0; corrComp< kNcorrelationComponents; corrComp++){
-          fVn[iTrkDetector*nEPDetectors+iEPDetector][h][corrComp] =
-              new TProfile(Form("vn_%sx%s_%s_h%d", namesQnTrackDetectors[iTrkDetector].Data(), namesQnEPDetectors[iEPDetector].Data(), namesQnComponents[corrComp].Data(),h+1),
-                  Form("vn_%sx%s_%s_h%d", namesQnTrackDetectors[iTrkDetector].Data(), namesQnEPDetectors[iEPDetector].Data(), namesQnComponents[corrComp].Data(),h+1),
-                  nQnCentBins,
-                  centQnBinning);
+          TString profileName = VnProfileName(iTrkDetector, iEPDetector, h, corrComp);
+          fVn[VnIndex(iTrkDetector*fNoOfEPDetectors+iEPDetector, h, corrComp)] =
+              new TProfile(profileName.Data(), profileName.Data(), nQnCentBins, centQnBinning);
         }
       }
     }
   }
 
   /* create the needed correlation TProfile for each the detector resolution and desired additional detector configuration */
-  for(Int_t ixDetectorConfig = 0; ixDetectorConfig < nTrackDetectors*nEPDetectors; ixDetectorConfig++) {
-    /* filter out not initialized detector configurations */
-    if(fDetectorResolutionContributors[ixDetectorConfig][0]==-1) continue;
+  fDetectorResolutionCorrelations = new TProfile*[fNDetectorResolutions*nCorrelationPerDetector*fNoOfHarmonics];
+  for(Int_t ixDetectorConfig = 0; ixDetectorConfig < fNDetectorResolutions; ixDetectorConfig++) {
     for (Int_t iCorr = 0; iCorr < nCorrelationPerDetector; iCorr++) {
-      TString detectorOneName;
-      TString detectorTwoName;
-      TString correlationComponent;
-      switch (iCorr) {
-      case kABXX: {
-        detectorOneName = namesQnTrackDetectors[fDetectorResolutionContributors[ixDetectorConfig][0]];
-        detectorTwoName = namesQnEPDetectors[fDetectorResolutionContributors[ixDetectorConfig][1]];
-        correlationComponent = namesQnComponents[kXX];
-        break;
-      }
-      case kABYY: {
-        detectorOneName = namesQnTrackDetectors[fDetectorResolutionContributors[ixDetectorConfig][0]];
-        detectorTwoName = namesQnEPDetectors[fDetectorResolutionContributors[ixDetectorConfig][1]];
-        correlationComponent = namesQnComponents[kYY];
-        break;
-      }
-      case kACXX: {
-        detectorOneName = namesQnTrackDetectors[fDetectorResolutionContributors[ixDetectorConfig][0]];
-        detectorTwoName = namesQnEPDetectors[fDetectorResolutionContributors[ixDetectorConfig][2]];
-        correlationComponent = namesQnComponents[kXX];
-        break;
-      }
-      case kACYY: {
-        detectorOneName = namesQnTrackDetectors[fDetectorResolutionContributors[ixDetectorConfig][0]];
-        detectorTwoName = namesQnEPDetectors[fDetectorResolutionContributors[ixDetectorConfig][2]];
-        correlationComponent = namesQnComponents[kYY];
-        break;
-      }
-      case kBCXX: {
-        detectorOneName = namesQnEPDetectors[fDetectorResolutionContributors[ixDetectorConfig][1]];
-        detectorTwoName = namesQnEPDetectors[fDetectorResolutionContributors[ixDetectorConfig][2]];
-        correlationComponent = namesQnComponents[kXX];
-        break;
-      }
-      case kBCYY: {
-        detectorOneName = namesQnEPDetectors[fDetectorResolutionContributors[ixDetectorConfig][1]];
-        detectorTwoName = namesQnEPDetectors[fDetectorResolutionContributors[ixDetectorConfig][2]];
-        correlationComponent = namesQnComponents[kYY];
-        break;
-      }
-      }
-      for(Int_t h=0; h < kNharmonics; h++) {
-        TString profileName = Form("corr_%s%d_%sx%s_%s_h%d",
-            namesQnTrackDetectors[fDetectorResolutionContributors[ixDetectorConfig][0]].Data(),
-            ixDetectorConfig,
-            detectorOneName.Data(),
-            detectorTwoName.Data(),
-            correlationComponent.Data(),
-            h+1);
-        fDetectorResolutionCorrelations[ixDetectorConfig][iCorr][h] = new TProfile(profileName.Data(),profileName.Data(), nQnCentBins, centQnBinning);
+      for(Int_t h=0; h < fNoOfHarmonics; h++) {
+        TString profileName = CorrelationProfileName(ixDetectorConfig, iCorr, h);
+        fDetectorResolutionCorrelations[CorrelationIndex(ixDetectorConfig, iCorr, h)] =
+            new TProfile(profileName.Data(),profileName.Data(), nQnCentBins, centQnBinning);
       }
     }
   }
 
-  /* create the sub-event structures to store the cross correlations */
+  /* the profiles are only filled at the end, out of the accumulators */
+  fVnAccumulator = new AliQnCorrectionsProfileAccumulator(fNoOfTrackDetectors*fNoOfEPDetectors,
+      fNoOfHarmonics*kNcorrelationComponents, nQnCentBins, centQnBinning);
+  fCorrelationsAccumulator = new AliQnCorrectionsProfileAccumulator(fNDetectorResolutions,
+      fNoOfHarmonics*nCorrelationPerDetector, nQnCentBins, centQnBinning);
 
-  DefineInput(0,TChain::Class());
-  DefineInput(1,TList::Class());
-  DefineOutput(1, TList::Class());// Event QA histograms
-}
+  if (!(fNoOfSubsamples > 1)) return;
 
-AliAnalysisTaskQnVectorAnalysis::~AliAnalysisTaskQnVectorAnalysis() {
-  /* clean up everything before leaving */
-  for(Int_t iTrkDetector=0; iTrkDetector < nTrackDetectors; iTrkDetector++) {
-    for (Int_t iEPDetector=0; iEPDetector < nEPDetectors; iEPDetector++) {
-      for(Int_t h=0; h<kNharmonics; h++) {
+  /* the subsample profiles carry the subsample index in the Y axis */
+  fVnSubsamples = new TProfile2D*[fNoOfTrackDetectors*fNoOfEPDetectors*fNoOfHarmonics*kNcorrelationComponents];
+  for(Int_t iTrkDetector=0; iTrkDetector < fNoOfTrackDetectors; iTrkDetector++) {
+    for (Int_t iEPDetector=0; iEPDetector < fNoOfEPDetectors; iEPDetector++) {
+      for(Int_t h=0; h<fNoOfHarmonics; h++) {
         for(Int_t corrComp =0; corrComp< kNcorrelationComponents; corrComp++){
-          delete fVn[iTrkDetector*nEPDetectors+iEPDetector][h][corrComp];
+          TString profileName = VnProfileName(iTrkDetector, iEPDetector, h, corrComp) + "_subsamples";
+          fVnSubsamples[VnIndex(iTrkDetector*fNoOfEPDetectors+iEPDetector, h, corrComp)] =
+              new TProfile2D(profileName.Data(), profileName.Data(), nQnCentBins, centQnBinning, fNoOfSubsamples, -0.5, fNoOfSubsamples - 0.5);
         }
       }
     }
   }
-  for(Int_t ixDetectorConfig = 0; ixDetectorConfig < nTrackDetectors*nEPDetectors; ixDetectorConfig++) {
-    /* filter out not initialized detector configurations */
-    if(fDetectorResolutionContributors[ixDetectorConfig][0]==-1) continue;
+  fDetectorResolutionCorrelationsSubsamples = new TProfile2D*[fNDetectorResolutions*nCorrelationPerDetector*fNoOfHarmonics];
+  for(Int_t ixDetectorConfig = 0; ixDetectorConfig < fNDetectorResolutions; ixDetectorConfig++) {
     for (Int_t iCorr = 0; iCorr < nCorrelationPerDetector; iCorr++) {
-      for(Int_t h=0; h < kNharmonics; h++) {
-        delete fDetectorResolutionCorrelations[ixDetectorConfig][iCorr][h];
+      for(Int_t h=0; h < fNoOfHarmonics; h++) {
+        TString profileName = CorrelationProfileName(ixDetectorConfig, iCorr, h) + "_subsamples";
+        fDetectorResolutionCorrelationsSubsamples[CorrelationIndex(ixDetectorConfig, iCorr, h)] =
+            new TProfile2D(profileName.Data(), profileName.Data(), nQnCentBins, centQnBinning, fNoOfSubsamples, -0.5, fNoOfSubsamples - 0.5);
       }
     }
-    for(Int_t h=0; h < kNharmonics; h++) {
-      // delete fDetectorResolution[ixDetectorConfig][h];
-      // delete fNewDetectorResolution[ixDetectorConfig][h];
-    }
   }
+
+  /* each subsample is a block of combinations in the accumulators */
+  fVnSubsamplesAccumulator = new AliQnCorrectionsProfileAccumulator(fNoOfSubsamples*fNoOfTrackDetectors*fNoOfEPDetectors,
+      fNoOfHarmonics*kNcorrelationComponents, nQnCentBins, centQnBinning);
+  fCorrelationsSubsamplesAccumulator = new AliQnCorrectionsProfileAccumulator(fNoOfSubsamples*fNDetectorResolutions,
+      fNoOfHarmonics*nCorrelationPerDetector, nQnCentBins, centQnBinning);
 }
+
+/// Gets the subsample of an event
+///
+/// The bits of the run number and event identifier are mixed so that
+/// the subsamples are not aligned with the filling scheme
+/// \param run the event run number
+/// \param eventId the event identifier within the run
+/// \return the event subsample
+Int_t AliAnalysisTaskQnVectorAnalysis::GetSubsample(Int_t run, ULong64_t eventId) const {
+
+  ULong64_t key = eventId ^ (ULong64_t(run) * 0x9e3779b97f4a7c15ULL);
+
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
+
+  return Int_t(key % ULong64_t(fNoOfSubsamples));
+}
+
 //_________________________________________________________________________________
 void AliAnalysisTaskQnVectorAnalysis::UserCreateOutputObjects()
 {
@@ -273,6 +423,10 @@ void AliAnalysisTaskQnVectorAnalysis::UserCreateOutputObjects()
   // Add all histogram manager histogram lists to the output TList
   //
 
+  SetDefaultConfiguration();
+  CreateProfiles();
+  SubscribeQnVectors();
+
   PostData(1, fEventQAList);
 
 }
@@ -287,131 +441,102 @@ void AliAnalysisTaskQnVectorAnalysis::UserExec(Option_t *){
 
   fEvent = InputEvent();
 
-  /* this is an option that requiers the Qn vector from an input container */
-  /* Get the Qn vectors list */
-  /* TList* qnlist = dynamic_cast<TList*>(GetInputData(1));
-     if(!qnlist) return;
-
-#define MAXNOOFDATAVARIABLES 2048
-
-     Float_t values[MAXNOOFDATAVARIABLES] = {-999.};
-     fDataBank = values;
-
-     FillEventData();
-     */
-
-  /* this is another option more convenient and which provides support for future functionality */
-  AliQnCorrectionsManager *flowQnVectorMgr;
-  AliAnalysisTaskFlowVectorCorrections *flowQnVectorTask =
-      dynamic_cast<AliAnalysisTaskFlowVectorCorrections *>(AliAnalysisManager::GetAnalysisManager()->GetTask("FlowQnVectorCorrections"));
-  if (flowQnVectorTask != NULL) {
-    flowQnVectorMgr = flowQnVectorTask->GetAliQnCorrectionsManager();
-  }
-  else {
-    AliFatal("This task needs the Flow Qn vector corrections framework and it is not present. Aborting!!!");
-  }
-
-  TList *qnlist = flowQnVectorMgr->GetQnVectorList();
-  Float_t *values = flowQnVectorMgr->GetDataContainer();
+  /* the Qn vectors come from the subscriptions to the corrections task */
+  Float_t *values = fFlowQnVectorTask->GetAliQnCorrectionsManager()->GetDataContainer();
   fDataBank = values;
 
   fEventPlaneHistos->FillHistClass("Event_NoCuts", values);
   if(!IsEventSelected(values)) return;
   fEventPlaneHistos->FillHistClass("Event_Analysis", values);
 
-  TList* newTrkQvecList[nTrackDetectors] = {NULL};
-  TList* newEPQvecList[nEPDetectors] = {NULL};
-  const AliQnCorrectionsQnVector* newTrk_qvec[nTrackDetectors] = {NULL};
-  const AliQnCorrectionsQnVector* newEP_qvec[nEPDetectors] = {NULL};
-
+  /* the components of the Qn vectors for the configured harmonics, extracted once per detector */
+  const AliQnCorrectionsQnVector* newTrk_qvec[fMaxNoOfDetectors] = {NULL};
+  const AliQnCorrectionsQnVector* newEP_qvec[fMaxNoOfDetectors] = {NULL};
+  Float_t trkQx[fMaxNoOfDetectors][fMaxNoOfHarmonics];
+  Float_t trkQy[fMaxNoOfDetectors][fMaxNoOfHarmonics];
+  Float_t trkQxNorm[fMaxNoOfDetectors][fMaxNoOfHarmonics];
+  Float_t trkQyNorm[fMaxNoOfDetectors][fMaxNoOfHarmonics];
+  Float_t epQxNorm[fMaxNoOfDetectors][fMaxNoOfHarmonics];
+  Float_t epQyNorm[fMaxNoOfDetectors][fMaxNoOfHarmonics];
 
   /* get Qn vectors for the different track detectors */
-  for (Int_t iTrk = 0; iTrk < nTrackDetectors; iTrk++) {
-    newTrk_qvec[iTrk] = GetQnVectorFromList(qnlist,
-        fTrackDetectorNameInFile[iTrk].Data(),
-        fExpectedCorrectionPass.Data(),
-        fAlternativeCorrectionPass.Data());
+  for (Int_t iTrk = 0; iTrk < fNoOfTrackDetectors; iTrk++) {
+    newTrk_qvec[iTrk] = fFlowQnVectorTask->GetSubscribedQnVector(fTrackDetectorQnVectorSubscription[iTrk]);
+    if (newTrk_qvec[iTrk] == NULL) continue;
+    for (Int_t h = 0; h < fNoOfHarmonics; h++) {
+      trkQx[iTrk][h] = newTrk_qvec[iTrk]->Qx(fHarmonic[h]);
+      trkQy[iTrk][h] = newTrk_qvec[iTrk]->Qy(fHarmonic[h]);
+      trkQxNorm[iTrk][h] = newTrk_qvec[iTrk]->QxNorm(fHarmonic[h]);
+      trkQyNorm[iTrk][h] = newTrk_qvec[iTrk]->QyNorm(fHarmonic[h]);
+    }
   }
 
   /* and now for the EP detectors */
-  for (Int_t iEP = 0; iEP < nEPDetectors; iEP++) {
-    newEP_qvec[iEP] = GetQnVectorFromList(qnlist,
-        fEPDetectorNameInFile[iEP].Data(),
-        fExpectedCorrectionPass.Data(),
-        fAlternativeCorrectionPass.Data());
+  for (Int_t iEP = 0; iEP < fNoOfEPDetectors; iEP++) {
+    newEP_qvec[iEP] = fFlowQnVectorTask->GetSubscribedQnVector(fEPDetectorQnVectorSubscription[iEP]);
+    if (newEP_qvec[iEP] == NULL) continue;
+    for (Int_t h = 0; h < fNoOfHarmonics; h++) {
+      epQxNorm[iEP][h] = newEP_qvec[iEP]->QxNorm(fHarmonic[h]);
+      epQyNorm[iEP][h] = newEP_qvec[iEP]->QyNorm(fHarmonic[h]);
+    }
   }
 
+  /* the centrality bin is the same for all the profiles */
+  Double_t centrality = values[fCentralityVariable];
+  Int_t centralityBin = fVnAccumulator->FindBin(centrality);
+
+  /* and so is the subsample */
+  Int_t subsample = 0;
+  if (fVnSubsamplesAccumulator != NULL)
+    subsample = GetSubsample(fEvent->GetRunNumber(), fFlowQnVectorTask->GetEventIdentifier());
+
   /* now fill the Vn profiles with the proper data */
-  for(Int_t iTrkDetector=0; iTrkDetector < nTrackDetectors; iTrkDetector++) {
+  Double_t vnValues[fMaxNoOfHarmonics*kNcorrelationComponents];
+  for(Int_t iTrkDetector=0; iTrkDetector < fNoOfTrackDetectors; iTrkDetector++) {
     /* sanity check */
     if (newTrk_qvec[iTrkDetector] != NULL) {
-      for (Int_t iEPDetector=0; iEPDetector < nEPDetectors; iEPDetector++) {
+      for (Int_t iEPDetector=0; iEPDetector < fNoOfEPDetectors; iEPDetector++) {
         /*sanity check */
         if (newEP_qvec[iEPDetector] != NULL) {
-          for(Int_t h=0; h < kNharmonics; h++) {
-            fVn[iTrkDetector*nEPDetectors+iEPDetector][h][0]->Fill(values[fCentralityVariable],
-                    newTrk_qvec[iTrkDetector]->Qx(h+1) * newEP_qvec[iEPDetector]->QxNorm(h+1));
-            fVn[iTrkDetector*nEPDetectors+iEPDetector][h][1]->Fill(values[fCentralityVariable],
-                    newTrk_qvec[iTrkDetector]->Qx(h+1) * newEP_qvec[iEPDetector]->QyNorm(h+1));
-            fVn[iTrkDetector*nEPDetectors+iEPDetector][h][2]->Fill(values[fCentralityVariable],
-                    newTrk_qvec[iTrkDetector]->Qy(h+1) * newEP_qvec[iEPDetector]->QxNorm(h+1));
-            fVn[iTrkDetector*nEPDetectors+iEPDetector][h][3]->Fill(values[fCentralityVariable],
-                    newTrk_qvec[iTrkDetector]->Qy(h+1) * newEP_qvec[iEPDetector]->QyNorm(h+1));
+          for(Int_t h=0; h < fNoOfHarmonics; h++) {
+            vnValues[h*kNcorrelationComponents+kXX] = trkQx[iTrkDetector][h] * epQxNorm[iEPDetector][h];
+            vnValues[h*kNcorrelationComponents+kXY] = trkQx[iTrkDetector][h] * epQyNorm[iEPDetector][h];
+            vnValues[h*kNcorrelationComponents+kYX] = trkQy[iTrkDetector][h] * epQxNorm[iEPDetector][h];
+            vnValues[h*kNcorrelationComponents+kYY] = trkQy[iTrkDetector][h] * epQyNorm[iEPDetector][h];
           }
+          fVnAccumulator->Fill(iTrkDetector*fNoOfEPDetectors+iEPDetector, centralityBin, centrality, vnValues);
+          if (fVnSubsamplesAccumulator != NULL)
+            fVnSubsamplesAccumulator->Fill((subsample*fNoOfTrackDetectors+iTrkDetector)*fNoOfEPDetectors+iEPDetector,
+                centralityBin, centrality, vnValues);
         }
       }
     }
   }
 
   /* now fill the correlation profiles needed for detector resolution */
+  Double_t correlationValues[fMaxNoOfHarmonics*nCorrelationPerDetector];
   for (Int_t ix = 0; ix < fNDetectorResolutions; ix++) {
-    /* sanity checks */
-    if(fDetectorResolutionContributors[ix][0] == -1) continue;
+    Int_t a = fDetectorResolutionContributors[ix][0];
+    Int_t b = fDetectorResolutionContributors[ix][1];
+    Int_t c = fDetectorResolutionContributors[ix][2];
 
     /* sanity checks */
-    if((newTrk_qvec[fDetectorResolutionContributors[ix][0]] != NULL) &&
-        (newEP_qvec[fDetectorResolutionContributors[ix][1]] != NULL) &&
-        (newEP_qvec[fDetectorResolutionContributors[ix][2]] != NULL)) {
-
-      for(Int_t h=0; h < kNharmonics; h++) {
-        for (Int_t iCorr = 0; iCorr < nCorrelationPerDetector; iCorr++) {
-          Float_t detectorOneValue;
-          Float_t detectorTwoValue;
-          switch (iCorr) {
-          case kABXX: {
-            detectorOneValue = newTrk_qvec[fDetectorResolutionContributors[ix][0]]->QxNorm(h+1);
-            detectorTwoValue = newEP_qvec[fDetectorResolutionContributors[ix][1]]->QxNorm(h+1);
-            break;
-          }
-          case kABYY: {
-            detectorOneValue = newTrk_qvec[fDetectorResolutionContributors[ix][0]]->QyNorm(h+1);
-            detectorTwoValue = newEP_qvec[fDetectorResolutionContributors[ix][1]]->QyNorm(h+1);
-            break;
-          }
-          case kACXX: {
-            detectorOneValue = newTrk_qvec[fDetectorResolutionContributors[ix][0]]->QxNorm(h+1);
-            detectorTwoValue = newEP_qvec[fDetectorResolutionContributors[ix][2]]->QxNorm(h+1);
-            break;
-          }
-          case kACYY: {
-            detectorOneValue = newTrk_qvec[fDetectorResolutionContributors[ix][0]]->QyNorm(h+1);
-            detectorTwoValue = newEP_qvec[fDetectorResolutionContributors[ix][2]]->QyNorm(h+1);
-            break;
-          }
-          case kBCXX: {
-            detectorOneValue = newEP_qvec[fDetectorResolutionContributors[ix][1]]->QxNorm(h+1);
-            detectorTwoValue = newEP_qvec[fDetectorResolutionContributors[ix][2]]->QxNorm(h+1);
-            break;
-          }
-          case kBCYY: {
-            detectorOneValue = newEP_qvec[fDetectorResolutionContributors[ix][1]]->QyNorm(h+1);
-            detectorTwoValue = newEP_qvec[fDetectorResolutionContributors[ix][2]]->QyNorm(h+1);
-            break;
-          }
-          }
-          fDetectorResolutionCorrelations[ix][iCorr][h]->Fill(values[fCentralityVariable],detectorOneValue*detectorTwoValue);
-        }
+    if((newTrk_qvec[a] != NULL) && (newEP_qvec[b] != NULL) && (newEP_qvec[c] != NULL)) {
+      for(Int_t h=0; h < fNoOfHarmonics; h++) {
+        Float_t bQxNorm = epQxNorm[b][h];
+        Float_t bQyNorm = epQyNorm[b][h];
+        Float_t cQxNorm = epQxNorm[c][h];
+        Float_t cQyNorm = epQyNorm[c][h];
+        correlationValues[h*nCorrelationPerDetector+kABXX] = trkQxNorm[a][h] * bQxNorm;
+        correlationValues[h*nCorrelationPerDetector+kABYY] = trkQyNorm[a][h] * bQyNorm;
+        correlationValues[h*nCorrelationPerDetector+kACXX] = trkQxNorm[a][h] * cQxNorm;
+        correlationValues[h*nCorrelationPerDetector+kACYY] = trkQyNorm[a][h] * cQyNorm;
+        correlationValues[h*nCorrelationPerDetector+kBCXX] = bQxNorm * cQxNorm;
+        correlationValues[h*nCorrelationPerDetector+kBCYY] = bQyNorm * cQyNorm;
       }
+      fCorrelationsAccumulator->Fill(ix, centralityBin, centrality, correlationValues);
+      if (fCorrelationsSubsamplesAccumulator != NULL)
+        fCorrelationsSubsamplesAccumulator->Fill(subsample*fNDetectorResolutions+ix, centralityBin, centrality, correlationValues);
     }
   }
 }  // end loop over events
@@ -430,14 +555,31 @@ void AliAnalysisTaskQnVectorAnalysis::FinishTaskOutput()
     fEventQAList->Add(list);
   }
 
-  /* TODO: correct vn with detector resolution */
-  for(Int_t iTrkDetector=0; iTrkDetector < nTrackDetectors; iTrkDetector++) {
-    for (Int_t iEPDetector=0; iEPDetector < nEPDetectors; iEPDetector++) {
-      for(Int_t h=0; h < kNharmonics; h++) {
+  /* the profiles get their content from the accumulators */
+  for(Int_t iTrkDetector=0; iTrkDetector < fNoOfTrackDetectors; iTrkDetector++) {
+    for (Int_t iEPDetector=0; iEPDetector < fNoOfEPDetectors; iEPDetector++) {
+      for(Int_t h=0; h < fNoOfHarmonics; h++) {
         for(Int_t corrComp =0; corrComp< kNcorrelationComponents; corrComp++){
-          if (fVn[iTrkDetector*nEPDetectors+iEPDetector][h][corrComp]) {
-            fEventQAList->Add(fVn[iTrkDetector*nEPDetectors+iEPDetector][h][corrComp]);
-          }
+          fVnAccumulator->Materialise(iTrkDetector*fNoOfEPDetectors+iEPDetector, h*kNcorrelationComponents+corrComp,
+              fVn[VnIndex(iTrkDetector*fNoOfEPDetectors+iEPDetector, h, corrComp)]);
+        }
+      }
+    }
+  }
+  for (Int_t ix = 0; ix < fNDetectorResolutions; ix++) {
+    for (Int_t iCorr = 0; iCorr < nCorrelationPerDetector; iCorr++) {
+      for(Int_t h=0; h < fNoOfHarmonics; h++) {
+        fCorrelationsAccumulator->Materialise(ix, h*nCorrelationPerDetector+iCorr,
+            fDetectorResolutionCorrelations[CorrelationIndex(ix, iCorr, h)]);
+      }
+    }
+  }
+
+  for(Int_t iTrkDetector=0; iTrkDetector < fNoOfTrackDetectors; iTrkDetector++) {
+    for (Int_t iEPDetector=0; iEPDetector < fNoOfEPDetectors; iEPDetector++) {
+      for(Int_t h=0; h < fNoOfHarmonics; h++) {
+        for(Int_t corrComp =0; corrComp< kNcorrelationComponents; corrComp++){
+          fEventQAList->Add(fVn[VnIndex(iTrkDetector*fNoOfEPDetectors+iEPDetector, h, corrComp)]);
         }
       }
     }
@@ -445,15 +587,342 @@ void AliAnalysisTaskQnVectorAnalysis::FinishTaskOutput()
 
   for (Int_t ix = 0; ix < fNDetectorResolutions; ix++) {
     for (Int_t iCorr = 0; iCorr < nCorrelationPerDetector; iCorr++) {
-      for(Int_t h=0; h < kNharmonics; h++) {
-        fEventQAList->Add(fDetectorResolutionCorrelations[ix][iCorr][h]);
+      for(Int_t h=0; h < fNoOfHarmonics; h++) {
+        fEventQAList->Add(fDetectorResolutionCorrelations[CorrelationIndex(ix, iCorr, h)]);
+      }
+    }
+  }
+
+  /* the subsample profiles, one row per subsample */
+  if (fVnSubsamples != NULL) {
+    for(Int_t iTrkDetector=0; iTrkDetector < fNoOfTrackDetectors; iTrkDetector++) {
+      for (Int_t iEPDetector=0; iEPDetector < fNoOfEPDetectors; iEPDetector++) {
+        for(Int_t h=0; h < fNoOfHarmonics; h++) {
+          for(Int_t corrComp =0; corrComp< kNcorrelationComponents; corrComp++){
+            TProfile2D *profile = fVnSubsamples[VnIndex(iTrkDetector*fNoOfEPDetectors+iEPDetector, h, corrComp)];
+            for (Int_t k = 0; k < fNoOfSubsamples; k++) {
+              fVnSubsamplesAccumulator->MaterialiseRow((k*fNoOfTrackDetectors+iTrkDetector)*fNoOfEPDetectors+iEPDetector,
+                  h*kNcorrelationComponents+corrComp, profile, k+1);
+            }
+            fEventQAList->Add(profile);
+          }
+        }
+      }
+    }
+    for (Int_t ix = 0; ix < fNDetectorResolutions; ix++) {
+      for (Int_t iCorr = 0; iCorr < nCorrelationPerDetector; iCorr++) {
+        for(Int_t h=0; h < fNoOfHarmonics; h++) {
+          TProfile2D *profile = fDetectorResolutionCorrelationsSubsamples[CorrelationIndex(ix, iCorr, h)];
+          for (Int_t k = 0; k < fNoOfSubsamples; k++) {
+            fCorrelationsSubsamplesAccumulator->MaterialiseRow(k*fNDetectorResolutions+ix, h*nCorrelationPerDetector+iCorr, profile, k+1);
+          }
+          fEventQAList->Add(profile);
+        }
       }
     }
   }
 
+  /* the detector resolution and the resolution corrected vn out of this task profiles */
+  ComputeResolutionAndVn(fEventQAList);
+
   PostData(1, fEventQAList);
 }
 
+//__________________________________________________________________
+void AliAnalysisTaskQnVectorAnalysis::Terminate(Option_t *)
+{
+  //
+  // Terminate, on the merged output
+  //
+
+  TList *list = dynamic_cast<TList *>(GetOutputData(1));
+  if (list == NULL) {
+    AliError("The output list is not available. Detector resolution and corrected vn not updated");
+    return;
+  }
+
+  /* the graphs merged from the different workers are rebuilt out of the merged profiles */
+  SetDefaultConfiguration();
+  ComputeResolutionAndVn(list);
+}
+
+/// Evaluates, with the 3-(sub-event)detector method, the resolution of a detector
+/// in a centrality bin
+///
+/// With only one of the Qn vector components used, the resolution of the detector
+/// is \f$ R = \sqrt{2 \langle Q_{1} Q_{2} \rangle \langle Q_{1} Q_{3} \rangle / \langle Q_{2} Q_{3} \rangle} \f$,
+/// with the statistical errors of the three correlations propagated.
+/// \param withOne the correlation of the detector with the first other detector
+/// \param withTwo the correlation of the detector with the second other detector
+/// \param oneWithTwo the correlation between the two other detectors
+/// \param bin the correlations profile bin
+/// \param resolution the detector resolution
+/// \param error the detector resolution error
+/// \return kTRUE if the resolution could be evaluated
+Bool_t AliAnalysisTaskQnVectorAnalysis::SubEventResolution(const TH1 *withOne, const TH1 *withTwo, const TH1 *oneWithTwo, Int_t bin,
+    Double_t &resolution, Double_t &error) {
+
+  Double_t one = withOne->GetBinContent(bin);
+  Double_t two = withTwo->GetBinContent(bin);
+  Double_t oneTwo = oneWithTwo->GetBinContent(bin);
+
+  if (oneTwo == 0.0) return kFALSE;
+  Double_t resolution2 = 2.0 * one * two / oneTwo;
+  /* no resolution for unphysical, i.e. negative, estimates */
+  if (!(resolution2 > 0.0)) return kFALSE;
+
+  resolution = TMath::Sqrt(resolution2);
+  error = 0.5 * resolution * TMath::Sqrt(TMath::Power(withOne->GetBinError(bin) / one, 2)
+      + TMath::Power(withTwo->GetBinError(bin) / two, 2)
+      + TMath::Power(oneWithTwo->GetBinError(bin) / oneTwo, 2));
+  return kTRUE;
+}
+
+/// Evaluates the resolution corrected vn in a centrality bin
+///
+/// As only one component is used, vn = 2 <u Q> / R, with R the EP detector
+/// resolution as evaluated by SubEventResolution.
+/// \param vn the vn profile
+/// \param withOne the correlation of the EP detector with the first other detector
+/// \param withTwo the correlation of the EP detector with the second other detector
+/// \param oneWithTwo the correlation between the two other detectors
+/// \param bin the profiles bin
+/// \param value the corrected vn
+/// \param error the corrected vn error
+/// \return kTRUE if the corrected vn could be evaluated
+Bool_t AliAnalysisTaskQnVectorAnalysis::CorrectedVn(const TH1 *vn, const TH1 *withOne, const TH1 *withTwo, const TH1 *oneWithTwo, Int_t bin,
+    Double_t &value, Double_t &error) {
+
+  Double_t resolution;
+  Double_t resolutionError;
+  /* empty bins are skipped */
+  if (vn->GetBinContent(bin) == 0.0 && vn->GetBinError(bin) == 0.0) return kFALSE;
+  if (!SubEventResolution(withOne, withTwo, oneWithTwo, bin, resolution, resolutionError)) return kFALSE;
+
+  value = 2.0 * vn->GetBinContent(bin) / resolution;
+  error = TMath::Sqrt(TMath::Power(2.0 * vn->GetBinError(bin) / resolution, 2)
+      + TMath::Power(value * resolutionError / resolution, 2));
+  return kTRUE;
+}
+
+/// Evaluates the mean over the subsamples and its standard error
+/// \param sum the sum of the subsample values
+/// \param sum2 the sum of the squared subsample values
+/// \param n the number of subsamples with value
+/// \param mean the mean
+/// \param error the standard error of the mean out of the subsamples spread
+/// \return kTRUE if there were enough subsamples
+Bool_t AliAnalysisTaskQnVectorAnalysis::SubsampleMeanAndError(Double_t sum, Double_t sum2, Int_t n, Double_t &mean, Double_t &error) {
+  if (n < 2) return kFALSE;
+  mean = sum / n;
+  Double_t variance = (sum2 - n * mean * mean) / (n - 1);
+  error = (variance > 0.0) ? TMath::Sqrt(variance / n) : 0.0;
+  return kTRUE;
+}
+
+/// Stores a graph in a list replacing, if there, the one with the same name
+/// \param list the list
+/// \param graph the graph to store
+void AliAnalysisTaskQnVectorAnalysis::ReplaceInList(TList *list, TGraphErrors *graph) {
+  TObject *previous = list->FindObject(graph->GetName());
+  if (previous != NULL) {
+    list->Remove(previous);
+    delete previous;
+  }
+  list->Add(graph);
+}
+
+/// Builds the detector resolution and the resolution corrected vn graphs
+///
+/// The resolution of each of the three detectors of each triplet is evaluated per
+/// harmonic, Qn vector component and centrality bin out of the correlation profiles.
+/// The XX and YY vn profiles of each track and EP detector combination are then
+/// corrected with the EP detector resolution from the first triplet that contains
+/// both detectors.
+/// If the subsample profiles are there, the same quantities are evaluated for each
+/// subsample and their mean, with the error out of the subsamples spread, is stored
+/// in the graphs with the `_subsamples` suffix.
+/// The profiles are taken by name from the passed list so that the same evaluation
+/// works on the task output and on the merged output. The graphs are stored in
+/// the list replacing any previous version.
+/// \param list the list with the profiles
+void AliAnalysisTaskQnVectorAnalysis::ComputeResolutionAndVn(TList *list) const {
+
+  const Int_t components[kNxy] = {kXX, kYY};
+  const Int_t correlationAB[kNxy] = {kABXX, kABYY};
+  const Int_t correlationAC[kNxy] = {kACXX, kACYY};
+  const Int_t correlationBC[kNxy] = {kBCXX, kBCYY};
+
+  for (Int_t ix = 0; ix < fNDetectorResolutions; ix++) {
+    const TString *detectorNames[kNresolutionComponents] = {
+        &fTrackDetectorName[fDetectorResolutionContributors[ix][0]],
+        &fEPDetectorName[fDetectorResolutionContributors[ix][1]],
+        &fEPDetectorName[fDetectorResolutionContributors[ix][2]]
+    };
+    for (Int_t h = 0; h < fNoOfHarmonics; h++) {
+      for (Int_t xy = 0; xy < kNxy; xy++) {
+        TString abName = CorrelationProfileName(ix, correlationAB[xy], h);
+        TString acName = CorrelationProfileName(ix, correlationAC[xy], h);
+        TString bcName = CorrelationProfileName(ix, correlationBC[xy], h);
+        TProfile *ab = dynamic_cast<TProfile *>(list->FindObject(abName.Data()));
+        TProfile *ac = dynamic_cast<TProfile *>(list->FindObject(acName.Data()));
+        TProfile *bc = dynamic_cast<TProfile *>(list->FindObject(bcName.Data()));
+        if (ab == NULL || ac == NULL || bc == NULL) continue;
+        TProfile2D *abSubsamples = dynamic_cast<TProfile2D *>(list->FindObject((abName + "_subsamples").Data()));
+        TProfile2D *acSubsamples = dynamic_cast<TProfile2D *>(list->FindObject((acName + "_subsamples").Data()));
+        TProfile2D *bcSubsamples = dynamic_cast<TProfile2D *>(list->FindObject((bcName + "_subsamples").Data()));
+        Bool_t subsamples = (abSubsamples != NULL && acSubsamples != NULL && bcSubsamples != NULL);
+
+        /* the same correlations in different order give the resolution of each of the three detectors */
+        const TH1 *withOne[kNresolutionComponents] = {ab, ab, ac};
+        const TH1 *withTwo[kNresolutionComponents] = {ac, bc, bc};
+        const TH1 *oneWithTwo[kNresolutionComponents] = {bc, ac, ab};
+        const TH1 *withOneSubsamples[kNresolutionComponents] = {abSubsamples, abSubsamples, acSubsamples};
+        const TH1 *withTwoSubsamples[kNresolutionComponents] = {acSubsamples, bcSubsamples, bcSubsamples};
+        const TH1 *oneWithTwoSubsamples[kNresolutionComponents] = {bcSubsamples, acSubsamples, abSubsamples};
+        for (Int_t iDetector = 0; iDetector < kNresolutionComponents; iDetector++) {
+          TString graphName = Form("res_%s%d_%s_%s_h%d",
+              detectorNames[0]->Data(), ix, detectorNames[iDetector]->Data(), namesQnComponents[components[xy]].Data(), fHarmonic[h]);
+          TGraphErrors *graph = new TGraphErrors();
+          graph->SetName(graphName.Data());
+          graph->SetTitle(graphName.Data());
+          Int_t nPoints = 0;
+          for (Int_t bin = 1; bin <= nQnCentBins; bin++) {
+            Double_t resolution;
+            Double_t error;
+            if (SubEventResolution(withOne[iDetector], withTwo[iDetector], oneWithTwo[iDetector], bin, resolution, error)) {
+              graph->SetPoint(nPoints, centQnBinningmid[bin-1], resolution);
+              graph->SetPointError(nPoints, 0.5 * (centQnBinning[bin] - centQnBinning[bin-1]), error);
+              nPoints++;
+            }
+          }
+          ReplaceInList(list, graph);
+
+          if (!subsamples) continue;
+          TGraphErrors *graphSubsamples = new TGraphErrors();
+          graphSubsamples->SetName((graphName + "_subsamples").Data());
+          graphSubsamples->SetTitle((graphName + "_subsamples").Data());
+          nPoints = 0;
+          for (Int_t bin = 1; bin <= nQnCentBins; bin++) {
+            Double_t sum = 0.0;
+            Double_t sum2 = 0.0;
+            Int_t n = 0;
+            for (Int_t k = 1; k <= abSubsamples->GetNbinsY(); k++) {
+              Double_t resolution;
+              Double_t error;
+              if (SubEventResolution(withOneSubsamples[iDetector], withTwoSubsamples[iDetector], oneWithTwoSubsamples[iDetector],
+                  abSubsamples->GetBin(bin, k), resolution, error)) {
+                sum += resolution;
+                sum2 += resolution * resolution;
+                n++;
+              }
+            }
+            Double_t mean;
+            Double_t error;
+            if (SubsampleMeanAndError(sum, sum2, n, mean, error)) {
+              graphSubsamples->SetPoint(nPoints, centQnBinningmid[bin-1], mean);
+              graphSubsamples->SetPointError(nPoints, 0.5 * (centQnBinning[bin] - centQnBinning[bin-1]), error);
+              nPoints++;
+            }
+          }
+          ReplaceInList(list, graphSubsamples);
+        }
+      }
+    }
+  }
+
+  for (Int_t iTrkDetector = 0; iTrkDetector < fNoOfTrackDetectors; iTrkDetector++) {
+    for (Int_t iEPDetector = 0; iEPDetector < fNoOfEPDetectors; iEPDetector++) {
+      /* the first triplet with both detectors provides the EP detector resolution */
+      Int_t triplet = -1;
+      Bool_t isB = kFALSE;
+      for (Int_t ix = 0; ix < fNDetectorResolutions; ix++) {
+        if (fDetectorResolutionContributors[ix][0] != iTrkDetector) continue;
+        if (fDetectorResolutionContributors[ix][1] == iEPDetector) {
+          triplet = ix;
+          isB = kTRUE;
+          break;
+        }
+        if (fDetectorResolutionContributors[ix][2] == iEPDetector) {
+          triplet = ix;
+          break;
+        }
+      }
+      if (triplet < 0) continue;
+
+      for (Int_t h = 0; h < fNoOfHarmonics; h++) {
+        for (Int_t xy = 0; xy < kNxy; xy++) {
+          TString vnName = VnProfileName(iTrkDetector, iEPDetector, h, components[xy]);
+          TString abName = CorrelationProfileName(triplet, correlationAB[xy], h);
+          TString acName = CorrelationProfileName(triplet, correlationAC[xy], h);
+          TString bcName = CorrelationProfileName(triplet, correlationBC[xy], h);
+          TProfile *vn = dynamic_cast<TProfile *>(list->FindObject(vnName.Data()));
+          TProfile *ab = dynamic_cast<TProfile *>(list->FindObject(abName.Data()));
+          TProfile *ac = dynamic_cast<TProfile *>(list->FindObject(acName.Data()));
+          TProfile *bc = dynamic_cast<TProfile *>(list->FindObject(bcName.Data()));
+          if (vn == NULL || ab == NULL || ac == NULL || bc == NULL) continue;
+          TProfile2D *vnSubsamples = dynamic_cast<TProfile2D *>(list->FindObject((vnName + "_subsamples").Data()));
+          TProfile2D *abSubsamples = dynamic_cast<TProfile2D *>(list->FindObject((abName + "_subsamples").Data()));
+          TProfile2D *acSubsamples = dynamic_cast<TProfile2D *>(list->FindObject((acName + "_subsamples").Data()));
+          TProfile2D *bcSubsamples = dynamic_cast<TProfile2D *>(list->FindObject((bcName + "_subsamples").Data()));
+          Bool_t subsamples = (vnSubsamples != NULL && abSubsamples != NULL && acSubsamples != NULL && bcSubsamples != NULL);
+
+          /* the EP detector resolution depends on its role in the triplet */
+          const TH1 *withOne = isB ? ab : ac;
+          const TH1 *oneWithTwo = isB ? ac : ab;
+          const TH1 *withOneSubsamples = isB ? abSubsamples : acSubsamples;
+          const TH1 *oneWithTwoSubsamples = isB ? acSubsamples : abSubsamples;
+
+          TString graphName = Form("vncorr_%sx%s_%s_h%d", fTrackDetectorName[iTrkDetector].Data(), fEPDetectorName[iEPDetector].Data(),
+              namesQnComponents[components[xy]].Data(), fHarmonic[h]);
+          TGraphErrors *graph = new TGraphErrors();
+          graph->SetName(graphName.Data());
+          graph->SetTitle(graphName.Data());
+          Int_t nPoints = 0;
+          for (Int_t bin = 1; bin <= nQnCentBins; bin++) {
+            Double_t value;
+            Double_t error;
+            if (CorrectedVn(vn, withOne, bc, oneWithTwo, bin, value, error)) {
+              graph->SetPoint(nPoints, centQnBinningmid[bin-1], value);
+              graph->SetPointError(nPoints, 0.5 * (centQnBinning[bin] - centQnBinning[bin-1]), error);
+              nPoints++;
+            }
+          }
+          ReplaceInList(list, graph);
+
+          if (!subsamples) continue;
+          TGraphErrors *graphSubsamples = new TGraphErrors();
+          graphSubsamples->SetName((graphName + "_subsamples").Data());
+          graphSubsamples->SetTitle((graphName + "_subsamples").Data());
+          nPoints = 0;
+          for (Int_t bin = 1; bin <= nQnCentBins; bin++) {
+            Double_t sum = 0.0;
+            Double_t sum2 = 0.0;
+            Int_t n = 0;
+            for (Int_t k = 1; k <= vnSubsamples->GetNbinsY(); k++) {
+              Double_t value;
+              Double_t error;
+              if (CorrectedVn(vnSubsamples, withOneSubsamples, bcSubsamples, oneWithTwoSubsamples, vnSubsamples->GetBin(bin, k), value, error)) {
+                sum += value;
+                sum2 += value * value;
+                n++;
+              }
+            }
+            Double_t mean;
+            Double_t error;
+            if (SubsampleMeanAndError(sum, sum2, n, mean, error)) {
+              graphSubsamples->SetPoint(nPoints, centQnBinningmid[bin-1], mean);
+              graphSubsamples->SetPointError(nPoints, 0.5 * (centQnBinning[bin] - centQnBinning[bin-1]), error);
+              nPoints++;
+            }
+          }
+          ReplaceInList(list, graphSubsamples);
+        }
+      }
+    }
+  }
+}
+
 
 
 //__________________________________________________________________
@@ -462,36 +931,26 @@ Bool_t AliAnalysisTaskQnVectorAnalysis::IsEventSelected(Float_t* values) {
   return fEventCuts->IsSelected(values);
 }
 
-const AliQnCorrectionsQnVector *AliAnalysisTaskQnVectorAnalysis::GetQnVectorFromList(
-    const TList *list,
-    const char *subdetector,
-    const char *expectedstep,
-    const char *altstep) const {
-
-  AliQnCorrectionsQnVector *theQnVector = NULL;
-
-  TList *pQvecList = dynamic_cast<TList*> (list->FindObject(subdetector));
-  if (pQvecList != NULL) {
-    /* the detector is present */
-    if (TString(expectedstep).EqualTo("latest"))
-      theQnVector = (AliQnCorrectionsQnVector*) pQvecList->First();
-    else
-      theQnVector = (AliQnCorrectionsQnVector*) pQvecList->FindObject(expectedstep);
-
-    if (theQnVector == NULL || !(theQnVector->IsGoodQuality()) || !(theQnVector->GetN() != 0)) {
-      /* the Qn vector for the expected step was not there */
-      if (TString(altstep).EqualTo("latest"))
-        theQnVector = (AliQnCorrectionsQnVector*) pQvecList->First();
-      else
-        theQnVector = (AliQnCorrectionsQnVector*) pQvecList->FindObject(altstep);
-    }
+/// Locates the Qn vectors producer task and subscribes to the needed Qn vectors
+void AliAnalysisTaskQnVectorAnalysis::SubscribeQnVectors() {
+
+  fFlowQnVectorTask =
+      dynamic_cast<AliAnalysisTaskFlowVectorCorrections *>(AliAnalysisManager::GetAnalysisManager()->GetTask("FlowQnVectorCorrections"));
+  if (fFlowQnVectorTask == NULL) {
+    AliFatal("This task needs the Flow Qn vector corrections framework and it is not present. Aborting!!!");
+    return;
+  }
+
+  for (Int_t iTrk = 0; iTrk < fNoOfTrackDetectors; iTrk++) {
+    fTrackDetectorQnVectorSubscription[iTrk] = fFlowQnVectorTask->SubscribeQnVector(
+        fTrackDetectorNameInFile[iTrk].Data(),
+        fExpectedCorrectionPass.Data(),
+        fAlternativeCorrectionPass.Data());
   }
-  if (theQnVector != NULL) {
-    /* check the Qn vector quality */
-    if (!(theQnVector->IsGoodQuality()) || !(theQnVector->GetN() != 0))
-      /* not good quality, discarded */
-      theQnVector = NULL;
+  for (Int_t iEP = 0; iEP < fNoOfEPDetectors; iEP++) {
+    fEPDetectorQnVectorSubscription[iEP] = fFlowQnVectorTask->SubscribeQnVector(
+        fEPDetectorNameInFile[iEP].Data(),
+        fExpectedCorrectionPass.Data(),
+        fAlternativeCorrectionPass.Data());
   }
-  return theQnVector;
 }
-
@@ -20,8 +20,12 @@ class AliAnalysis;
 class AliQnCorrectionsManager;
 class AliQnCorrectionsCutsSet;
 class AliQnCorrectionsHistos;
+class AliAnalysisTaskFlowVectorCorrections;
+class AliQnCorrectionsProfileAccumulator;
 class TList;
 class TProfile;
+class TProfile2D;
+class TH1;
 class TGraphErrors;
 
 
@@ -30,6 +34,7 @@ class AliAnalysisTaskQnVectorAnalysis : public AliQnCorrectionsFillEventTask {
 
 public:
 
+  /* the default configuration detectors and number of harmonics */
   enum enumTrackDetectors{
     kTPC=0,
     kSPD,
@@ -83,6 +88,7 @@ public:
   virtual void UserExec(Option_t *);
   virtual void UserCreateOutputObjects();
   virtual void FinishTaskOutput();
+  virtual void Terminate(Option_t *);
 
   AliQnCorrectionsHistos* GetHistograms() {return fEventPlaneHistos;}
   AliQnCorrectionsCutsSet* EventCuts()  const {return fEventCuts;}
@@ -93,6 +99,18 @@ public:
   void SetExpectedCorrectionPass(const char *pass) { fExpectedCorrectionPass = pass; }
   void SetAlternativeCorrectionPass(const char *pass) { fAlternativeCorrectionPass = pass; }
 
+  /* analysis configuration, the defaults are used if nothing is configured */
+  void AddTrackDetector(const char *name, const char *nameInList);
+  void AddEPDetector(const char *name, const char *nameInList);
+  void AddHarmonic(Int_t harmonic);
+  void AddResolutionTriplet(const char *trackDetector, const char *epDetectorB, const char *epDetectorC);
+  /// Sets the number of subsamples for the statistical errors
+  ///
+  /// The events are assigned to a subsample by a hash of their run number and
+  /// identifier, so the assignment is the same whatever the job splitting.
+  /// \param nSubsamples the number of subsamples, no subsamples if less than two
+  void SetNoOfSubsamples(Int_t nSubsamples) { fNoOfSubsamples = nSubsamples; }
+
  private:
   TList* fEventQAList;
   AliQnCorrectionsCutsSet *fEventCuts;
@@ -100,23 +118,61 @@ public:
 
   AliAnalysisTaskQnVectorAnalysis(const AliAnalysisTaskQnVectorAnalysis &c);
   AliAnalysisTaskQnVectorAnalysis& operator= (const AliAnalysisTaskQnVectorAnalysis &c);
-  const AliQnCorrectionsQnVector *GetQnVectorFromList(const TList *list, const char *subdetector, const char *expectedstep = "latest", const char *altstep = "latest") const;
-
-  TProfile* fVn[nTrackDetectors*nEPDetectors][kNharmonics][kNcorrelationComponents];
-
-  Int_t fNDetectorResolutions;
-  TGraphErrors* fDetectorResolution[nTrackDetectors*nEPDetectors][kNharmonics];
-  Int_t fDetectorResolutionContributors[nTrackDetectors*nEPDetectors][kNresolutionComponents];
-  TProfile *fDetectorResolutionCorrelations[nTrackDetectors*nEPDetectors][nCorrelationPerDetector][kNharmonics];
-
-  TString fTrackDetectorNameInFile[nTrackDetectors];
-  TString fEPDetectorNameInFile[nEPDetectors];
+  void SubscribeQnVectors();
+  void SetDefaultConfiguration();
+  void CreateProfiles();
+  Int_t FindDetector(const TString *names, Int_t nDetectors, const char *name) const;
+  TString VnProfileName(Int_t trkDetector, Int_t epDetector, Int_t h, Int_t component) const;
+  TString CorrelationProfileName(Int_t triplet, Int_t correlation, Int_t h) const;
+  void ComputeResolutionAndVn(TList *list) const;
+  Int_t GetSubsample(Int_t run, ULong64_t eventId) const;
+  static Bool_t SubEventResolution(const TH1 *withOne, const TH1 *withTwo, const TH1 *oneWithTwo, Int_t bin,
+      Double_t &resolution, Double_t &error);
+  static Bool_t CorrectedVn(const TH1 *vn, const TH1 *withOne, const TH1 *withTwo, const TH1 *oneWithTwo, Int_t bin,
+      Double_t &value, Double_t &error);
+  static Bool_t SubsampleMeanAndError(Double_t sum, Double_t sum2, Int_t n, Double_t &mean, Double_t &error);
+  static void ReplaceInList(TList *list, TGraphErrors *graph);
+  /// the index of a Vn profile
+  Int_t VnIndex(Int_t combination, Int_t h, Int_t component) const
+    { return (combination * fNoOfHarmonics + h) * kNcorrelationComponents + component; }
+  /// the index of a detector resolution correlation profile
+  Int_t CorrelationIndex(Int_t triplet, Int_t correlation, Int_t h) const
+    { return (triplet * nCorrelationPerDetector + correlation) * fNoOfHarmonics + h; }
+
+  static const Int_t fMaxNoOfDetectors = 8;             ///< the maximum number of track and of EP detectors
+  static const Int_t fMaxNoOfHarmonics = 8;             ///< the maximum number of harmonics
+  static const Int_t fMaxNoOfResolutionTriplets = 16;   ///< the maximum number of detector resolution triplets
+
+  Int_t fNoOfTrackDetectors;                            ///< the number of track detectors
+  TString fTrackDetectorName[fMaxNoOfDetectors];        ///< the name of each track detector in the output profiles
+  TString fTrackDetectorNameInFile[fMaxNoOfDetectors];  ///< the name of each track detector in the Qn vectors list
+  Int_t fNoOfEPDetectors;                               ///< the number of EP detectors
+  TString fEPDetectorName[fMaxNoOfDetectors];           ///< the name of each EP detector in the output profiles
+  TString fEPDetectorNameInFile[fMaxNoOfDetectors];     ///< the name of each EP detector in the Qn vectors list
+  Int_t fNoOfHarmonics;                                 ///< the number of harmonics
+  Int_t fHarmonic[fMaxNoOfHarmonics];                   ///< the harmonics
+  Int_t fNDetectorResolutions;                          ///< the number of detector resolution triplets
+  Int_t fDetectorResolutionContributors[fMaxNoOfResolutionTriplets][kNresolutionComponents]; ///< track, EP and EP detector of each triplet
+  Int_t fNoOfSubsamples;                                ///< the number of subsamples for the statistical errors
+
+  TProfile **fVn;                                       //!<! the Vn profiles per combination, harmonic and component. Transient!
+  TProfile **fDetectorResolutionCorrelations;           //!<! the correlation profiles per triplet, correlation and harmonic. Transient!
+  TProfile2D **fVnSubsamples;                           //!<! the Vn profiles per subsample. Transient!
+  TProfile2D **fDetectorResolutionCorrelationsSubsamples; //!<! the correlation profiles per subsample. Transient!
+
+  AliAnalysisTaskFlowVectorCorrections *fFlowQnVectorTask;    //!<! the Qn vectors producer task. Transient!
+  Int_t fTrackDetectorQnVectorSubscription[fMaxNoOfDetectors];  //!<! the Qn vector subscription of each track detector. Transient!
+  Int_t fEPDetectorQnVectorSubscription[fMaxNoOfDetectors];     //!<! the Qn vector subscription of each EP detector. Transient!
+  AliQnCorrectionsProfileAccumulator *fVnAccumulator;          //!<! the accumulator behind the Vn profiles. Transient!
+  AliQnCorrectionsProfileAccumulator *fCorrelationsAccumulator; //!<! the accumulator behind the resolution correlation profiles. Transient!
+  AliQnCorrectionsProfileAccumulator *fVnSubsamplesAccumulator; //!<! the accumulator behind the Vn subsample profiles. Transient!
+  AliQnCorrectionsProfileAccumulator *fCorrelationsSubsamplesAccumulator; //!<! the accumulator behind the correlation subsample profiles. Transient!
 
   Int_t fCentralityVariable;
   TString fExpectedCorrectionPass;
   TString fAlternativeCorrectionPass;
 
-  ClassDef(AliAnalysisTaskQnVectorAnalysis, 1);
+  ClassDef(AliAnalysisTaskQnVectorAnalysis, 5);
 };
 
 #endif
@@ -0,0 +1,376 @@
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <TSystem.h>
+#include <TFile.h>
+#include <TMD5.h>
+#include <TObjArray.h>
+#include <TObjString.h>
+#include <TArrayL64.h>
+#include <TTimeStamp.h>
+#include "AliLog.h"
+
+#include "AliQnCorrectionsCalibrationFetcher.h"
+#include "AliQnCorrectionsCalibrationCache.h"
+
+ClassImp(AliQnCorrectionsCalibrationCache)
+
+/// Default constructor
+AliQnCorrectionsCalibrationCache::AliQnCorrectionsCalibrationCache() :
+    TObject(),
+    fDirectory(""),
+    fMaxSize(0),
+    fFetcher(NULL),
+    fInitialized(kFALSE),
+    fNoOfHits(0),
+    fNoOfMisses(0)
+{
+}
+
+/// Normal constructor
+/// \param directory the cache directory
+/// \param maxSize the maximum size, in bytes, of the cached files
+/// \param fetcher the fetch backend, the cache takes ownership. NULL for the default one
+AliQnCorrectionsCalibrationCache::AliQnCorrectionsCalibrationCache(const char *directory, Long64_t maxSize, AliQnCorrectionsCalibrationFetcher *fetcher) :
+    TObject(),
+    fDirectory(directory),
+    fMaxSize(maxSize),
+    fFetcher(fetcher),
+    fInitialized(kFALSE),
+    fNoOfHits(0),
+    fNoOfMisses(0)
+{
+  if (fFetcher == NULL) fFetcher = new AliQnCorrectionsCalibrationFetcher();
+}
+
+/// Default destructor
+AliQnCorrectionsCalibrationCache::~AliQnCorrectionsCalibrationCache() {
+  delete fFetcher;
+}
+
+/// Gets the local cached copy of a calibration file
+///
+/// If the file is not in the cache, or the cached copy is corrupted,
+/// it is fetched and stored in the cache.
+/// \param source the calibration file source name
+/// \return the cached file name, empty if the file could not be made available
+TString AliQnCorrectionsCalibrationCache::GetCachedFileName(const char *source) {
+
+  if (!Initialize()) return TString("");
+
+  TString fileName = Lookup(source);
+  if (fileName.Length() != 0) {
+    fNoOfHits++;
+    return fileName;
+  }
+  fNoOfMisses++;
+  return Insert(source);
+}
+
+/// Opens the local cached copy of a calibration file
+/// \param source the calibration file source name
+/// \return the open file, NULL if the file could not be made available
+TFile *AliQnCorrectionsCalibrationCache::Open(const char *source) {
+
+  TString fileName = GetCachedFileName(source);
+  if (fileName.Length() == 0) return NULL;
+
+  AliInfo(Form("Calibration file %s taken from cache as %s", source, fileName.Data()));
+  TFile *file = TFile::Open(fileName);
+  if (file != NULL && !file->IsOpen()) {
+    delete file;
+    file = NULL;
+  }
+  return file;
+}
+
+/// Brings a set of calibration files to the cache
+/// \param sources the calibration files source names as TObjString
+/// \return the number of files available in the cache
+Int_t AliQnCorrectionsCalibrationCache::Prefetch(const TObjArray *sources) {
+
+  Int_t nAvailable = 0;
+  for (Int_t i = 0; i < sources->GetEntriesFast(); i++) {
+    const char *source = ((TObjString *) sources->At(i))->GetString().Data();
+    if (GetCachedFileName(source).Length() != 0)
+      nAvailable++;
+    else
+      AliWarning(Form("Calibration file %s could not be prefetched", source));
+  }
+  AliInfo(Form("%d out of %d calibration files available in cache %s",
+      nAvailable, sources->GetEntriesFast(), fDirectory.Data()));
+  return nAvailable;
+}
+
+/// Gets the name a calibration file is stored under in the cache
+///
+/// Only the cache references are looked at, neither the file content is
+/// checked nor the file is fetched if missing.
+/// \param source the calibration file source name
+/// \return the stored file name, empty if not in the cache
+TString AliQnCorrectionsCalibrationCache::GetStoredFileName(const char *source) {
+
+  if (!Initialize()) return TString("");
+
+  char line[64] = "";
+  FILE *reference = fopen(GetReferenceFileName(source).Data(), "r");
+  if (reference == NULL) return TString("");
+  if (fgets(line, sizeof(line), reference) == NULL) line[0] = '\0';
+  fclose(reference);
+  line[strcspn(line, "\n")] = '\0';
+
+  TString fileName = GetObjectFileName(line);
+  if (line[0] == '\0' || gSystem->AccessPathName(fileName)) return TString("");
+  return fileName;
+}
+
+/// Gets the temporary place a calibration file is fetched to before being stored
+/// \param source the calibration file source name
+/// \return the temporary file name, empty if the cache is not usable
+TString AliQnCorrectionsCalibrationCache::GetTemporaryFileName(const char *source) {
+
+  if (!Initialize()) return TString("");
+  return TString(Form("%s/tmp/%s.%d", fDirectory.Data(), GetChecksum(source).Data(), gSystem->GetPid()));
+}
+
+/// Stores in the cache a calibration file fetched outside of it
+///
+/// The file has to be fetched to the place given by GetTemporaryFileName.
+/// It is checked as the files the cache fetcher brings, but for its size,
+/// which is not known, and it is removed from its temporary place in any case.
+/// \param source the calibration file source name
+/// \param fetchedFileName the fetched file name
+/// \return the cached file name, empty if the fetched file is not valid
+TString AliQnCorrectionsCalibrationCache::StoreFetched(const char *source, const char *fetchedFileName) {
+
+  fNoOfMisses++;
+  return Store(source, fetchedFileName, -1);
+}
+
+/// Builds, if needed, the cache directory structure
+/// \return kTRUE if the cache is usable
+Bool_t AliQnCorrectionsCalibrationCache::Initialize() {
+
+  if (fInitialized) return kTRUE;
+
+  const char *subdirs[3] = { "objects", "refs", "tmp" };
+  for (Int_t i = 0; i < 3; i++) {
+    TString subdir = Form("%s/%s", fDirectory.Data(), subdirs[i]);
+    /* weird ROOT convention, kTRUE if the path is NOT there */
+    if (gSystem->AccessPathName(subdir))
+      gSystem->mkdir(subdir, kTRUE);
+    if (gSystem->AccessPathName(subdir, kWritePermission)) {
+      AliError(Form("Calibration cache directory %s not usable. Not using the cache", subdir.Data()));
+      return kFALSE;
+    }
+  }
+  fInitialized = kTRUE;
+  return kTRUE;
+}
+
+/// Looks for a calibration file in the cache
+///
+/// The cached file content is checked against its checksum. Corrupted
+/// files are removed. A found file is marked as recently used.
+/// \param source the calibration file source name
+/// \return the cached file name, empty if not in the cache
+TString AliQnCorrectionsCalibrationCache::Lookup(const char *source) {
+
+  TString referenceFileName = GetReferenceFileName(source);
+  if (gSystem->AccessPathName(referenceFileName)) return TString("");
+
+  char line[64] = "";
+  FILE *reference = fopen(referenceFileName.Data(), "r");
+  if (reference == NULL) return TString("");
+  if (fgets(line, sizeof(line), reference) == NULL) line[0] = '\0';
+  fclose(reference);
+  line[strcspn(line, "\n")] = '\0';
+  TString checksum = line;
+
+  TString fileName = GetObjectFileName(checksum);
+  if (checksum.Length() == 0 || gSystem->AccessPathName(fileName)) return TString("");
+
+  if (GetFileChecksum(fileName) != checksum) {
+    AliWarning(Form("Cached calibration file %s for %s is corrupted. Fetching it again", fileName.Data(), source));
+    gSystem->Unlink(fileName);
+    return TString("");
+  }
+
+  /* the modification time tracks the last use */
+  gSystem->Utime(fileName, TTimeStamp().GetSec(), 0);
+  return fileName;
+}
+
+/// Fetches a calibration file and stores it in the cache
+/// \param source the calibration file source name
+/// \return the cached file name, empty if the file could not be fetched
+TString AliQnCorrectionsCalibrationCache::Insert(const char *source) {
+
+  TString temporaryFileName = GetTemporaryFileName(source);
+
+  Long64_t sourceSize = -1;
+  if (!fFetcher->Fetch(source, temporaryFileName, sourceSize)) {
+    AliWarning(Form("Calibration file %s could not be fetched", source));
+    gSystem->Unlink(temporaryFileName);
+    return TString("");
+  }
+  return Store(source, temporaryFileName, sourceSize);
+}
+
+/// Stores in the cache a calibration file fetched in its temporary place
+///
+/// The fetched file is checked before being stored. It is removed from
+/// its temporary place in any case.
+/// \param source the calibration file source name
+/// \param fetchedFileName the fetched file name
+/// \param sourceSize the size of the source, in bytes, -1 if not known
+/// \return the cached file name, empty if the fetched file is not valid
+TString AliQnCorrectionsCalibrationCache::Store(const char *source, const char *fetchedFileName, Long64_t sourceSize) {
+
+  if (!IsValidFetch(source, fetchedFileName, sourceSize)) {
+    AliWarning(Form("Calibration file %s could not be fetched", source));
+    gSystem->Unlink(fetchedFileName);
+    return TString("");
+  }
+
+  TString checksum = GetFileChecksum(fetchedFileName);
+  if (checksum.Length() == 0) {
+    gSystem->Unlink(fetchedFileName);
+    return TString("");
+  }
+
+  /* the same content could have been stored meanwhile by other job */
+  TString fileName = GetObjectFileName(checksum);
+  if (gSystem->AccessPathName(fileName))
+    gSystem->Rename(fetchedFileName, fileName);
+  else
+    gSystem->Unlink(fetchedFileName);
+
+  TString referenceFileName = GetReferenceFileName(source);
+  TString temporaryReferenceFileName = Form("%s.%d", referenceFileName.Data(), gSystem->GetPid());
+  FILE *reference = fopen(temporaryReferenceFileName.Data(), "w");
+  if (reference != NULL) {
+    fprintf(reference, "%s\n", checksum.Data());
+    fclose(reference);
+    gSystem->Rename(temporaryReferenceFileName, referenceFileName);
+  }
+
+  Evict(fileName);
+  return fileName;
+}
+
+/// Checks a fetched calibration file before storing it in the cache
+///
+/// The fetched copy must have the size of its source, when the fetcher
+/// knows it, and must open as a ROOT file with keys without needing a
+/// recovery, which would mean it is truncated.
+/// \param source the calibration file source name
+/// \param fileName the fetched file name
+/// \param sourceSize the size of the source, in bytes, -1 if not known
+/// \return kTRUE if the fetched file can be stored in the cache
+Bool_t AliQnCorrectionsCalibrationCache::IsValidFetch(const char *source, const char *fileName, Long64_t sourceSize) {
+
+  FileStat_t stat;
+  if (gSystem->GetPathInfo(fileName, stat) != 0 || stat.fSize == 0) {
+    AliWarning(Form("Fetched calibration file %s for %s is empty", fileName, source));
+    return kFALSE;
+  }
+  if (!(sourceSize < 0) && stat.fSize != sourceSize) {
+    AliWarning(Form("Fetched calibration file %s for %s has %lld bytes instead of %lld",
+        fileName, source, stat.fSize, sourceSize));
+    return kFALSE;
+  }
+
+  TFile *file = TFile::Open(fileName, "READ");
+  Bool_t valid = (file != NULL && file->IsOpen() && !file->IsZombie() && !file->TestBit(TFile::kRecovered) &&
+      file->GetListOfKeys()->GetEntries() > 0);
+  if (file != NULL) file->Close();
+  delete file;
+  if (!valid)
+    AliWarning(Form("Fetched calibration file %s for %s is not a proper calibration file", fileName, source));
+  return valid;
+}
+
+/// Removes the least recently used cached files until the cache fits its size cap
+///
+/// The references to removed files are left behind. They are treated as
+/// misses next time they are used.
+/// \param keep the cached file not to remove
+void AliQnCorrectionsCalibrationCache::Evict(const char *keep) {
+
+  TString objectsDirectory = Form("%s/objects", fDirectory.Data());
+  void *dir = gSystem->OpenDirectory(objectsDirectory);
+  if (dir == NULL) return;
+
+  TObjArray fileNames;
+  fileNames.SetOwner(kTRUE);
+  TArrayL64 sizes(16);
+  TArrayL64 lastUse(16);
+  Long64_t totalSize = 0;
+
+  const char *entry;
+  while ((entry = gSystem->GetDirEntry(dir)) != NULL) {
+    if (!TString(entry).EndsWith(".root")) continue;
+    TString fileName = Form("%s/%s", objectsDirectory.Data(), entry);
+    FileStat_t stat;
+    if (gSystem->GetPathInfo(fileName, stat) != 0) continue;
+    Int_t n = fileNames.GetEntriesFast();
+    if (n == sizes.GetSize()) {
+      sizes.Set(2 * n);
+      lastUse.Set(2 * n);
+    }
+    fileNames.Add(new TObjString(fileName));
+    sizes[n] = stat.fSize;
+    lastUse[n] = stat.fMtime;
+    totalSize += stat.fSize;
+  }
+  gSystem->FreeDirectory(dir);
+
+  while (totalSize > fMaxSize) {
+    Int_t oldest = -1;
+    for (Int_t i = 0; i < fileNames.GetEntriesFast(); i++) {
+      if (fileNames.At(i) == NULL) continue;
+      if (((TObjString *) fileNames.At(i))->GetString() == keep) continue;
+      if (oldest < 0 || lastUse[i] < lastUse[oldest]) oldest = i;
+    }
+    if (oldest < 0) break;
+
+    const char *fileName = ((TObjString *) fileNames.At(oldest))->GetString().Data();
+    AliInfo(Form("Calibration cache over %lld bytes. Removing %s", fMaxSize, fileName));
+    gSystem->Unlink(fileName);
+    totalSize -= sizes[oldest];
+    delete fileNames.RemoveAt(oldest);
+  }
+}
+
+/// Gets the MD5 checksum of a string
+/// \param string the string
+/// \return the checksum as hexadecimal string
+TString AliQnCorrectionsCalibrationCache::GetChecksum(const char *string) {
+
+  TMD5 md5;
+  md5.Update((const UChar_t *) string, strlen(string));
+  md5.Final();
+  return TString(md5.AsString());
+}
+
+/// Gets the MD5 checksum of a file content
+/// \param fileName the file name
+/// \return the checksum as hexadecimal string, empty if the file could not be read
+TString AliQnCorrectionsCalibrationCache::GetFileChecksum(const char *fileName) {
+
+  TMD5 *md5 = TMD5::FileChecksum(fileName);
+  if (md5 == NULL) return TString("");
+  TString checksum = md5->AsString();
+  delete md5;
+  return checksum;
+}
@@ -0,0 +1,93 @@
+#ifndef ALIQNCORRECTIONS_CALIBRATIONCACHE_H
+#define ALIQNCORRECTIONS_CALIBRATIONCACHE_H
+
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+/// \file AliQnCorrectionsCalibrationCache.h
+/// \brief Node local cache of the calibration files
+///
+/// The calibration files are kept in a local directory shared by all the jobs
+/// running on the node. The files are content addressed: each one is stored
+/// as `objects/<md5 of content>.root` and the source name is mapped to it by
+/// a `refs/<md5 of source name>` file holding the content checksum. Files
+/// with the same content are then stored only once, and the content of a cached
+/// file is checked against its name before handing it out, which catches a
+/// cached file damaged after it was stored.
+///
+/// The checksum is computed from the fetched copy, so it says nothing about
+/// the fetch itself. New files are fetched by the cache fetcher to the `tmp`
+/// directory and only stored if the copy has the size of its source and opens
+/// as a ROOT file with keys, without recovery. They are then moved to their
+/// final place, so concurrent jobs never see partial files. When the cached files go beyond the size cap, the least recently used
+/// ones are removed.
+///
+/// A file can also be fetched outside the cache, to the place given by
+/// GetTemporaryFileName, and handed to StoreFetched, which checks and stores
+/// it as if the cache fetcher had brought it.
+
+#include <TObject.h>
+#include <TString.h>
+
+class TFile;
+class TObjArray;
+class AliQnCorrectionsCalibrationFetcher;
+
+class AliQnCorrectionsCalibrationCache : public TObject {
+public:
+  AliQnCorrectionsCalibrationCache();
+  AliQnCorrectionsCalibrationCache(const char *directory, Long64_t maxSize, AliQnCorrectionsCalibrationFetcher *fetcher = NULL);
+  virtual ~AliQnCorrectionsCalibrationCache();
+
+  TString GetCachedFileName(const char *source);
+  TFile *Open(const char *source);
+  Int_t Prefetch(const TObjArray *sources);
+  TString GetStoredFileName(const char *source);
+  TString GetTemporaryFileName(const char *source);
+  TString StoreFetched(const char *source, const char *fetchedFileName);
+
+  /// Gets the cache directory
+  /// \return the cache directory
+  const char *GetDirectory() const { return fDirectory.Data(); }
+  /// Gets the number of requests served from the cache
+  /// \return the number of hits
+  Int_t GetNoOfHits() const { return fNoOfHits; }
+  /// Gets the number of requests which needed a fetch
+  /// \return the number of misses
+  Int_t GetNoOfMisses() const { return fNoOfMisses; }
+
+private:
+  Bool_t Initialize();
+  TString Lookup(const char *source);
+  TString Insert(const char *source);
+  TString Store(const char *source, const char *fetchedFileName, Long64_t sourceSize);
+  void Evict(const char *keep);
+  Bool_t IsValidFetch(const char *source, const char *fileName, Long64_t sourceSize);
+  TString GetObjectFileName(const char *checksum) const
+    { return Form("%s/objects/%s.root", fDirectory.Data(), checksum); }
+  TString GetReferenceFileName(const char *source) const
+    { return Form("%s/refs/%s", fDirectory.Data(), GetChecksum(source).Data()); }
+
+  static TString GetChecksum(const char *string);
+  static TString GetFileChecksum(const char *fileName);
+
+  TString fDirectory;                    ///< the cache directory
+  Long64_t fMaxSize;                     ///< the maximum size, in bytes, of the cached files
+  AliQnCorrectionsCalibrationFetcher *fFetcher; ///< the fetch backend, owned by the cache
+  Bool_t fInitialized;                   //!<! the cache directory structure is in place. Transient!
+  Int_t fNoOfHits;                       //!<! the number of requests served from the cache. Transient!
+  Int_t fNoOfMisses;                     //!<! the number of requests which needed a fetch. Transient!
+
+  AliQnCorrectionsCalibrationCache(const AliQnCorrectionsCalibrationCache &c);
+  AliQnCorrectionsCalibrationCache& operator= (const AliQnCorrectionsCalibrationCache &c);
+
+  ClassDef(AliQnCorrectionsCalibrationCache, 1);
+};
+
+#endif // ALIQNCORRECTIONS_CALIBRATIONCACHE_H
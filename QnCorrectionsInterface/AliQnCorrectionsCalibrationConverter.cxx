@@ -0,0 +1,285 @@
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <TList.h>
+#include <TNamed.h>
+#include <TObjArray.h>
+#include <TArrayI.h>
+#include <TArrayL64.h>
+#include <TFile.h>
+#include <TKey.h>
+#include <TAxis.h>
+#include <TH1.h>
+#include <THnBase.h>
+#include "AliLog.h"
+
+#include "AliQnCorrectionsCalibrationConverter.h"
+
+ClassImp(AliQnCorrectionsCalibrationConverter)
+
+const char *AliQnCorrectionsCalibrationConverter::fgkMagic = "QNCALV01";
+
+/// Default constructor
+AliQnCorrectionsCalibrationConverter::AliQnCorrectionsCalibrationConverter() :
+    TObject()
+{
+}
+
+/// Default destructor
+AliQnCorrectionsCalibrationConverter::~AliQnCorrectionsCalibrationConverter() {
+}
+
+/// Converts a calibration histograms file to a flat parameters file
+///
+/// The calibration histograms list is taken, as the framework does, from
+/// the first key of the file. Each run list in it, named after the run,
+/// is converted.
+/// \param calibrationFileName the calibration histograms file name
+/// \param parametersFileName the flat parameters file name
+/// \return kTRUE if the conversion succeeded
+Bool_t AliQnCorrectionsCalibrationConverter::Convert(const char *calibrationFileName, const char *parametersFileName) {
+
+  TFile *calibrationFile = TFile::Open(calibrationFileName);
+  if (calibrationFile == NULL || !calibrationFile->IsOpen()) {
+    AliErrorClass(Form("Calibration file %s not available", calibrationFileName));
+    delete calibrationFile;
+    return kFALSE;
+  }
+  TKey *listKey = (calibrationFile->GetListOfKeys()->GetEntries() > 0) ? (TKey *) calibrationFile->GetListOfKeys()->At(0) : NULL;
+  TObject *obj = (listKey != NULL) ? listKey->ReadObj() : NULL;
+  if (obj == NULL || !obj->InheritsFrom(TList::Class())) {
+    AliErrorClass(Form("Calibration file %s does not contain a calibration histograms list", calibrationFileName));
+    delete obj;
+    calibrationFile->Close();
+    delete calibrationFile;
+    return kFALSE;
+  }
+  TList *list = (TList *) obj;
+  list->SetOwner(kTRUE);
+
+  /* the tables keys sort by run and path */
+  TObjArray keys;
+  keys.SetOwner(kTRUE);
+  TObjArray histograms;
+  TObjArray companions;
+  TArrayI runs(16);
+  TIter next(list);
+  TObject *entry;
+  while ((entry = next()) != NULL) {
+    if (!entry->InheritsFrom(TList::Class())) continue;
+    TString name = entry->GetName();
+    CollectTables((const TList *) entry, name.IsDigit() ? name.Atoi() : -1, "", keys, histograms, companions, runs);
+  }
+  keys.Sort();
+
+  FILE *file = fopen(parametersFileName, "wb");
+  if (file == NULL) {
+    AliErrorClass(Form("Parameters file %s cannot be created", parametersFileName));
+    delete list;
+    calibrationFile->Close();
+    delete calibrationFile;
+    return kFALSE;
+  }
+
+  static const Char_t zeros[fgkAlignment] = { 0 };
+  Int_t nTables = keys.GetEntriesFast();
+  TArrayL64 tableOffsets(nTables);
+  TArrayL64 tableNoOfParameters(nTables);
+  TArrayI tableNoOfDimensions(nTables);
+
+  /* the header is written once the directory offset is known */
+  fwrite(zeros, 1, fgkHeaderSize, file);
+  Long64_t offset = fgkHeaderSize;
+
+  for (Int_t table = 0; table < nTables; table++) {
+    Int_t index = keys.At(table)->GetUniqueID();
+    const TObject *histogram = histograms.At(index);
+    const TObject *companion = companions.At(index);
+
+    Int_t nDimensions = GetNoOfDimensions(histogram);
+    ULong64_t nBins[fgkMaxNoOfDimensions];
+    Long64_t nParameters = 1;
+    for (Int_t dim = 0; dim < nDimensions; dim++) {
+      nBins[dim] = GetAxis(histogram, dim)->GetNbins();
+      nParameters *= nBins[dim];
+    }
+    tableOffsets[table] = offset;
+    tableNoOfParameters[table] = nParameters;
+    tableNoOfDimensions[table] = nDimensions;
+
+    fwrite(nBins, sizeof(ULong64_t), nDimensions, file);
+    offset += nDimensions * sizeof(ULong64_t);
+    for (Int_t dim = 0; dim < nDimensions; dim++) {
+      const TAxis *axis = GetAxis(histogram, dim);
+      for (Int_t bin = 1; bin <= axis->GetNbins() + 1; bin++) {
+        Double_t edge = axis->GetBinLowEdge(bin);
+        fwrite(&edge, sizeof(Double_t), 1, file);
+      }
+      offset += (nBins[dim] + 1) * sizeof(Double_t);
+    }
+
+    /* the parameters, with the first dimension running fastest */
+    Int_t bins[fgkMaxNoOfDimensions];
+    for (Int_t dim = 0; dim < nDimensions; dim++) bins[dim] = 1;
+    Double_t *parameters = new Double_t[nParameters];
+    for (Long64_t parameter = 0; parameter < nParameters; parameter++) {
+      Double_t value = GetBinValue(histogram, bins);
+      if (companion != NULL) {
+        Double_t entries = GetBinValue(companion, bins);
+        value = (entries > 0) ? value / entries : 0.0;
+      }
+      parameters[parameter] = value;
+      for (Int_t dim = 0; dim < nDimensions; dim++) {
+        if (bins[dim] < Int_t(nBins[dim])) {
+          bins[dim]++;
+          break;
+        }
+        bins[dim] = 1;
+      }
+    }
+    fwrite(parameters, sizeof(Double_t), nParameters, file);
+    offset += nParameters * sizeof(Double_t);
+    delete [] parameters;
+
+    Long64_t padding = (fgkAlignment - (offset % fgkAlignment)) % fgkAlignment;
+    fwrite(zeros, 1, padding, file);
+    offset += padding;
+  }
+
+  ULong64_t directoryOffset = offset;
+  for (Int_t table = 0; table < nTables; table++) {
+    const TNamed *key = (const TNamed *) keys.At(table);
+    Char_t tableEntry[fgkTableEntrySize];
+    memset(tableEntry, 0, fgkTableEntrySize);
+    Int_t run = runs[key->GetUniqueID()];
+    UInt_t nDimensions = tableNoOfDimensions[table];
+    ULong64_t nParameters = tableNoOfParameters[table];
+    ULong64_t tableOffset = tableOffsets[table];
+    memcpy(tableEntry, &run, sizeof(Int_t));
+    memcpy(tableEntry + 4, &nDimensions, sizeof(UInt_t));
+    memcpy(tableEntry + 8, &nParameters, sizeof(ULong64_t));
+    memcpy(tableEntry + 16, &tableOffset, sizeof(ULong64_t));
+    strncpy(tableEntry + fgkTablePathOffset, key->GetTitle(), fgkTablePathLength - 1);
+    fwrite(tableEntry, 1, fgkTableEntrySize, file);
+  }
+
+  Char_t header[fgkHeaderSize];
+  memset(header, 0, fgkHeaderSize);
+  UInt_t version = fgkFormatVersion;
+  UInt_t nTablesField = nTables;
+  UInt_t byteOrderMarker = fgkByteOrderMarker;
+  memcpy(header, fgkMagic, 8);
+  memcpy(header + 8, &version, sizeof(UInt_t));
+  memcpy(header + 12, &nTablesField, sizeof(UInt_t));
+  memcpy(header + 16, &directoryOffset, sizeof(ULong64_t));
+  memcpy(header + 24, &byteOrderMarker, sizeof(UInt_t));
+  fseek(file, 0, SEEK_SET);
+  fwrite(header, 1, fgkHeaderSize, file);
+  fclose(file);
+
+  AliInfoClass(Form("Calibration file %s converted to parameters file %s with %d tables",
+      calibrationFileName, parametersFileName, nTables));
+
+  delete list;
+  calibrationFile->Close();
+  delete calibrationFile;
+  return kTRUE;
+}
+
+/// Collects recursively the tables of a run list
+///
+/// Entries companions are attached to their histogram and not collected as tables.
+/// \param list the list to collect the tables from
+/// \param run the run number
+/// \param path the path of the list within the run list
+/// \param keys the tables keys, the table index is kept as unique id
+/// \param histograms the tables histograms, by table index
+/// \param companions the tables entries companions, by table index. NULL if none
+/// \param runs the tables run, by table index
+void AliQnCorrectionsCalibrationConverter::CollectTables(const TList *list, Int_t run, const char *path,
+    TObjArray &keys, TObjArray &histograms, TObjArray &companions, TArrayI &runs) {
+
+  TIter next(list);
+  TObject *obj;
+  while ((obj = next()) != NULL) {
+    TString name = obj->GetName();
+    TString tablePath = (strlen(path) == 0) ? name : TString(Form("%s/%s", path, name.Data()));
+
+    if (obj->InheritsFrom(TList::Class())) {
+      CollectTables((const TList *) obj, run, tablePath, keys, histograms, companions, runs);
+      continue;
+    }
+    if (!obj->InheritsFrom(TH1::Class()) && !obj->InheritsFrom(THnBase::Class())) continue;
+    if (name.EndsWith("Entries") && list->FindObject(name(0, name.Length() - 7)) != NULL) continue;
+
+    if (!(tablePath.Length() < fgkTablePathLength) || GetNoOfDimensions(obj) > fgkMaxNoOfDimensions) {
+      AliWarningClass(Form("Calibration histogram %s of run %d cannot be stored as a table", tablePath.Data(), run));
+      continue;
+    }
+
+    Int_t index = histograms.GetEntriesFast();
+    TNamed *key = new TNamed(Form("%011d %s", run + 1, tablePath.Data()), tablePath.Data());
+    key->SetUniqueID(index);
+    keys.Add(key);
+    histograms.AddAtAndExpand(obj, index);
+    companions.AddAtAndExpand(list->FindObject(Form("%sEntries", name.Data())), index);
+    if (!(index < runs.GetSize())) runs.Set(2 * runs.GetSize());
+    runs[index] = run;
+  }
+}
+
+/// Gets the number of dimensions of a calibration histogram
+/// \param histogram the histogram
+/// \return the number of dimensions
+Int_t AliQnCorrectionsCalibrationConverter::GetNoOfDimensions(const TObject *histogram) {
+
+  if (histogram->InheritsFrom(THnBase::Class()))
+    return ((const THnBase *) histogram)->GetNdimensions();
+  return ((const TH1 *) histogram)->GetDimension();
+}
+
+/// Gets an axis of a calibration histogram
+/// \param histogram the histogram
+/// \param dimension the axis dimension
+/// \return the axis
+const TAxis *AliQnCorrectionsCalibrationConverter::GetAxis(const TObject *histogram, Int_t dimension) {
+
+  if (histogram->InheritsFrom(THnBase::Class()))
+    return ((const THnBase *) histogram)->GetAxis(dimension);
+  switch (dimension) {
+  case 0:
+    return ((const TH1 *) histogram)->GetXaxis();
+  case 1:
+    return ((const TH1 *) histogram)->GetYaxis();
+  default:
+    return ((const TH1 *) histogram)->GetZaxis();
+  }
+}
+
+/// Gets the value of a calibration histogram bin
+///
+/// The profiles give their bin averages. A sparse histogram bin
+/// not filled gives zero.
+/// \param histogram the histogram
+/// \param bins the bin number along each dimension
+/// \return the bin value
+Double_t AliQnCorrectionsCalibrationConverter::GetBinValue(const TObject *histogram, const Int_t *bins) {
+
+  if (histogram->InheritsFrom(THnBase::Class())) {
+    const THnBase *hn = (const THnBase *) histogram;
+    Long64_t bin = hn->GetBin(bins);
+    return (bin < 0) ? 0.0 : hn->GetBinContent(bin);
+  }
+  const TH1 *h = (const TH1 *) histogram;
+  Int_t nDimensions = h->GetDimension();
+  return h->GetBinContent(h->GetBin(bins[0], (nDimensions > 1) ? bins[1] : 0, (nDimensions > 2) ? bins[2] : 0));
+}
@@ -0,0 +1,85 @@
+#ifndef ALIQNCORRECTIONS_CALIBRATIONCONVERTER_H
+#define ALIQNCORRECTIONS_CALIBRATIONCONVERTER_H
+
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+/// \file AliQnCorrectionsCalibrationConverter.h
+/// \brief Converter of calibration histograms files to flat, memory mappable, parameter tables
+///
+/// Each calibration histogram of each run becomes a parameter table: its
+/// axes bin edges and one Double_t parameter per in range bin. The table
+/// is identified by the run and the histogram path within the run list,
+/// `<detector configuration>/<histogram name>`. Profiles give their bin
+/// averages. Histograms with an entries companion, a sibling with the same
+/// name plus the `Entries` suffix, give their bin averages as well, and the
+/// companion is not stored. The file is laid out so that it can be memory
+/// mapped and accessed without copying by AliQnCorrectionsCalibrationParameters.
+/// All the fields are stored in the native byte order of the producing node,
+/// which the header byte order marker records. The file is then only usable
+/// on nodes with the same byte order, which the loader checks.
+/// The parameter tables are a standalone tool: the framework only takes its
+/// calibration from histograms files, so the task does not load them.
+///
+///     file header (64 bytes)
+///       [ 0, 8) magic "QNCALV01"
+///       [ 8,12) UInt_t    format version
+///       [12,16) UInt_t    number of tables
+///       [16,24) ULong64_t offset of the tables directory
+///       [24,28) UInt_t    byte order marker, 0x01020304 as written by the producing node
+///     tables data, each one starting at a 64 bytes boundary
+///       one ULong64_t number of bins per dimension
+///       per dimension, the number of bins + 1 Double_t bin edges
+///       one Double_t parameter per bin, the first dimension running fastest
+///     tables directory, one 128 bytes entry per table, sorted by run and path
+///       [ 0, 4) Int_t     run number, -1 if the list is not a run one
+///       [ 4, 8) UInt_t    number of dimensions
+///       [ 8,16) ULong64_t number of parameters
+///       [16,24) ULong64_t offset of the table data
+///       [24,32) padding
+///       [32,128) table path, NUL terminated
+
+#include <TObject.h>
+
+class TList;
+class TObjArray;
+class TArrayI;
+class TAxis;
+
+class AliQnCorrectionsCalibrationConverter : public TObject {
+public:
+  AliQnCorrectionsCalibrationConverter();
+  virtual ~AliQnCorrectionsCalibrationConverter();
+
+  static Bool_t Convert(const char *calibrationFileName, const char *parametersFileName);
+
+  static const Int_t fgkAlignment = 64;            ///< the alignment of the header and the tables data within the file
+  static const Int_t fgkHeaderSize = 64;           ///< the size of the file header
+  static const Int_t fgkTableEntrySize = 128;      ///< the size of a tables directory entry
+  static const Int_t fgkTablePathOffset = 32;      ///< the offset of the path within a tables directory entry
+  static const Int_t fgkTablePathLength = 96;      ///< the room for the table path, NUL included
+  static const UInt_t fgkFormatVersion = 2;        ///< the current file format version
+  static const UInt_t fgkByteOrderMarker = 0x01020304; ///< the byte order marker, as written in native byte order
+  static const char *fgkMagic;                     ///< the file magic, eight characters
+  static const Int_t fgkMaxNoOfDimensions = 16;    ///< the maximum number of dimensions of a table
+
+private:
+  static void CollectTables(const TList *list, Int_t run, const char *path,
+      TObjArray &keys, TObjArray &histograms, TObjArray &companions, TArrayI &runs);
+  static Int_t GetNoOfDimensions(const TObject *histogram);
+  static const TAxis *GetAxis(const TObject *histogram, Int_t dimension);
+  static Double_t GetBinValue(const TObject *histogram, const Int_t *bins);
+
+  AliQnCorrectionsCalibrationConverter(const AliQnCorrectionsCalibrationConverter &c);
+  AliQnCorrectionsCalibrationConverter& operator= (const AliQnCorrectionsCalibrationConverter &c);
+
+  ClassDef(AliQnCorrectionsCalibrationConverter, 1);
+};
+
+#endif // ALIQNCORRECTIONS_CALIBRATIONCONVERTER_H
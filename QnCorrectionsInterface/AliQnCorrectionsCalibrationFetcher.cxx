@@ -0,0 +1,61 @@
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+#include <TString.h>
+#include <TFile.h>
+#include <TGrid.h>
+#include "AliLog.h"
+
+#include "AliQnCorrectionsCalibrationFetcher.h"
+
+ClassImp(AliQnCorrectionsCalibrationFetcher)
+
+/// Default constructor
+AliQnCorrectionsCalibrationFetcher::AliQnCorrectionsCalibrationFetcher() :
+    TObject()
+{
+}
+
+/// Default destructor
+AliQnCorrectionsCalibrationFetcher::~AliQnCorrectionsCalibrationFetcher() {
+}
+
+/// Copies a calibration file to a local file
+///
+/// The grid connection is only established if the source requires it
+/// and it is not already there. The source is opened once for getting
+/// its size and copying it.
+/// \param source the calibration file source name
+/// \param destination the local file name
+/// \param sourceSize the size of the source, in bytes, -1 if not known
+/// \return kTRUE if the copy succeeded
+Bool_t AliQnCorrectionsCalibrationFetcher::Fetch(const char *source, const char *destination, Long64_t &sourceSize) {
+
+  sourceSize = -1;
+
+  if (TString(source).BeginsWith("alien://") && gGrid == NULL) {
+    TGrid::Connect("alien://");
+    if (gGrid == NULL) {
+      AliError(Form("Not possible to connect to the grid for fetching %s", source));
+      return kFALSE;
+    }
+  }
+
+  TFile *file = TFile::Open(source);
+  if (file == NULL || !file->IsOpen()) {
+    AliError(Form("Calibration file %s not available for fetching", source));
+    delete file;
+    return kFALSE;
+  }
+  sourceSize = file->GetSize();
+  Bool_t copied = file->Cp(destination, kFALSE);
+  file->Close();
+  delete file;
+  return copied;
+}
@@ -0,0 +1,39 @@
+#ifndef ALIQNCORRECTIONS_CALIBRATIONFETCHER_H
+#define ALIQNCORRECTIONS_CALIBRATIONFETCHER_H
+
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+/// \file AliQnCorrectionsCalibrationFetcher.h
+/// \brief Fetch backend of the calibration files cache
+///
+/// The calibration files cache does not know where the calibration files
+/// come from. It asks its fetcher to bring a copy of a calibration file,
+/// identified by its source name, to a local file, and to report the size
+/// of the source so that the cache can check the copy. The default fetcher
+/// opens the source, connecting to the grid when it is an alien one, and
+/// copies it with TFile::Cp. Other backends derive from it and override Fetch.
+
+#include <TObject.h>
+
+class AliQnCorrectionsCalibrationFetcher : public TObject {
+public:
+  AliQnCorrectionsCalibrationFetcher();
+  virtual ~AliQnCorrectionsCalibrationFetcher();
+
+  virtual Bool_t Fetch(const char *source, const char *destination, Long64_t &sourceSize);
+
+private:
+  AliQnCorrectionsCalibrationFetcher(const AliQnCorrectionsCalibrationFetcher &c);
+  AliQnCorrectionsCalibrationFetcher& operator= (const AliQnCorrectionsCalibrationFetcher &c);
+
+  ClassDef(AliQnCorrectionsCalibrationFetcher, 1);
+};
+
+#endif // ALIQNCORRECTIONS_CALIBRATIONFETCHER_H
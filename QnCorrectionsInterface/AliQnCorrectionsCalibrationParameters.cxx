@@ -0,0 +1,256 @@
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <TMath.h>
+#include "AliLog.h"
+
+#include "AliQnCorrectionsCalibrationParameters.h"
+
+ClassImp(AliQnCorrectionsCalibrationParameters)
+
+/// Default constructor
+AliQnCorrectionsCalibrationParameters::AliQnCorrectionsCalibrationParameters() :
+    TObject(),
+    fMap(NULL),
+    fMapSize(0),
+    fNoOfTables(0),
+    fDirectoryOffset(0)
+{
+}
+
+/// Default destructor
+/// Releases the file mapping if still there
+AliQnCorrectionsCalibrationParameters::~AliQnCorrectionsCalibrationParameters() {
+  Close();
+}
+
+/// Maps the file and checks its header
+/// \param filename the calibration parameters file name
+/// \return kTRUE if the file was properly mapped
+Bool_t AliQnCorrectionsCalibrationParameters::Open(const char *filename) {
+  Close();
+
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    AliError(Form("Calibration parameters file %s cannot be opened", filename));
+    return kFALSE;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < AliQnCorrectionsCalibrationConverter::fgkHeaderSize) {
+    AliError(Form("Calibration parameters file %s is not a calibration parameters file", filename));
+    close(fd);
+    return kFALSE;
+  }
+  void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  /* the mapping stays valid once the descriptor is closed */
+  close(fd);
+  if (map == MAP_FAILED) {
+    AliError(Form("Calibration parameters file %s cannot be mapped", filename));
+    return kFALSE;
+  }
+  fMap = (const Char_t *) map;
+  fMapSize = st.st_size;
+
+  UInt_t version;
+  UInt_t nTables;
+  ULong64_t directoryOffset;
+  UInt_t byteOrderMarker;
+  memcpy(&version, fMap + 8, sizeof(UInt_t));
+  memcpy(&nTables, fMap + 12, sizeof(UInt_t));
+  memcpy(&directoryOffset, fMap + 16, sizeof(ULong64_t));
+  memcpy(&byteOrderMarker, fMap + 24, sizeof(UInt_t));
+
+  if (memcmp(fMap, AliQnCorrectionsCalibrationConverter::fgkMagic, 8) != 0) {
+    AliError(Form("Calibration parameters file %s is not a calibration parameters file", filename));
+    Close();
+    return kFALSE;
+  }
+  /* the fields are in the byte order of the producing node, the mapping is used as is */
+  if (byteOrderMarker != AliQnCorrectionsCalibrationConverter::fgkByteOrderMarker) {
+    AliError(Form("Calibration parameters file %s was written with a different byte order", filename));
+    Close();
+    return kFALSE;
+  }
+  if (version != AliQnCorrectionsCalibrationConverter::fgkFormatVersion) {
+    AliError(Form("Calibration parameters file %s format version %u not supported", filename, version));
+    Close();
+    return kFALSE;
+  }
+  if (directoryOffset < ULong64_t(AliQnCorrectionsCalibrationConverter::fgkHeaderSize) ||
+      directoryOffset + ULong64_t(nTables) * AliQnCorrectionsCalibrationConverter::fgkTableEntrySize > (ULong64_t) fMapSize) {
+    AliError(Form("Calibration parameters file %s was not properly written", filename));
+    Close();
+    return kFALSE;
+  }
+
+  fNoOfTables = nTables;
+  fDirectoryOffset = directoryOffset;
+  return kTRUE;
+}
+
+/// Releases the file mapping
+void AliQnCorrectionsCalibrationParameters::Close() {
+  if (fMap != NULL)
+    munmap((void *) fMap, fMapSize);
+  fMap = NULL;
+  fMapSize = 0;
+  fNoOfTables = 0;
+  fDirectoryOffset = 0;
+}
+
+/// Finds a table by its run and path
+///
+/// The tables directory is sorted by run and path so the search is binary.
+/// \param run the run number, -1 for the tables not in a run list
+/// \param path the table path within the run list
+/// \return the table index, -1 if not found
+Int_t AliQnCorrectionsCalibrationParameters::FindTable(Int_t run, const char *path) const {
+  Int_t low = 0;
+  Int_t high = fNoOfTables - 1;
+  while (!(high < low)) {
+    Int_t middle = (low + high) / 2;
+    Int_t tableRun = GetTableRun(middle);
+    Int_t comparison = (tableRun < run) ? -1 : ((run < tableRun) ? 1 :
+        strncmp(GetTablePath(middle), path, AliQnCorrectionsCalibrationConverter::fgkTablePathLength));
+    if (comparison == 0) return middle;
+    if (comparison < 0)
+      low = middle + 1;
+    else
+      high = middle - 1;
+  }
+  return -1;
+}
+
+/// Gets the run of a table
+/// \param table the table index
+/// \return the table run, -1 if the table is not there or not in a run list
+Int_t AliQnCorrectionsCalibrationParameters::GetTableRun(Int_t table) const {
+  if (table < 0 || !(table < fNoOfTables)) return -1;
+  Int_t run;
+  memcpy(&run, GetTableEntry(table), sizeof(Int_t));
+  return run;
+}
+
+/// Gets the path of a table
+/// \param table the table index
+/// \return the table path, empty if the table is not there
+const char *AliQnCorrectionsCalibrationParameters::GetTablePath(Int_t table) const {
+  if (table < 0 || !(table < fNoOfTables)) return "";
+  return GetTableEntry(table) + AliQnCorrectionsCalibrationConverter::fgkTablePathOffset;
+}
+
+/// Gets the number of dimensions of a table
+/// \param table the table index
+/// \return the number of dimensions, zero if the table is not there
+Int_t AliQnCorrectionsCalibrationParameters::GetNoOfDimensions(Int_t table) const {
+  if (table < 0 || !(table < fNoOfTables)) return 0;
+  UInt_t nDimensions;
+  memcpy(&nDimensions, GetTableEntry(table) + 4, sizeof(UInt_t));
+  return nDimensions;
+}
+
+/// Gets the number of parameters of a table
+/// \param table the table index
+/// \return the number of parameters, zero if the table is not there
+Long64_t AliQnCorrectionsCalibrationParameters::GetNoOfParameters(Int_t table) const {
+  if (table < 0 || !(table < fNoOfTables)) return 0;
+  ULong64_t nParameters;
+  memcpy(&nParameters, GetTableEntry(table) + 8, sizeof(ULong64_t));
+  return nParameters;
+}
+
+/// Gets the offset of a table data within the mapping
+/// \param table the table index
+/// \return the table data offset
+ULong64_t AliQnCorrectionsCalibrationParameters::GetTableOffset(Int_t table) const {
+  ULong64_t offset;
+  memcpy(&offset, GetTableEntry(table) + 16, sizeof(ULong64_t));
+  return offset;
+}
+
+/// Gets the number of bins of a table along a dimension
+/// \param table the table index
+/// \param dimension the dimension
+/// \return the number of bins, zero if not there
+Long64_t AliQnCorrectionsCalibrationParameters::GetNoOfBins(Int_t table, Int_t dimension) const {
+  if (dimension < 0 || !(dimension < GetNoOfDimensions(table))) return 0;
+  return ((const ULong64_t *) (fMap + GetTableOffset(table)))[dimension];
+}
+
+/// Gets the bin edges of a table along a dimension
+///
+/// The edges are within the file mapping, no copy is made. They stay
+/// valid until the file is closed.
+/// \param table the table index
+/// \param dimension the dimension
+/// \return the number of bins + 1 bin edges, NULL if not there
+const Double_t *AliQnCorrectionsCalibrationParameters::GetBinEdges(Int_t table, Int_t dimension) const {
+  Int_t nDimensions = GetNoOfDimensions(table);
+  if (dimension < 0 || !(dimension < nDimensions)) return NULL;
+
+  const ULong64_t *nBins = (const ULong64_t *) (fMap + GetTableOffset(table));
+  const Double_t *edges = (const Double_t *) (nBins + nDimensions);
+  for (Int_t previous = 0; previous < dimension; previous++)
+    edges += nBins[previous] + 1;
+  return edges;
+}
+
+/// Gets the parameters of a table
+///
+/// The parameters are within the file mapping, no copy is made. They
+/// stay valid until the file is closed. The first dimension runs fastest.
+/// \param table the table index
+/// \return the table parameters, NULL if not there
+const Double_t *AliQnCorrectionsCalibrationParameters::GetParameters(Int_t table) const {
+  Int_t nDimensions = GetNoOfDimensions(table);
+  if (nDimensions == 0) return NULL;
+
+  const Double_t *parameters = GetBinEdges(table, nDimensions - 1) + GetNoOfBins(table, nDimensions - 1) + 1;
+  if ((const Char_t *) (parameters + GetNoOfParameters(table)) > fMap + fMapSize) return NULL;
+  return parameters;
+}
+
+/// Finds the parameter index of a table for a set of coordinates
+///
+/// The bin along each dimension is found by binary search over its edges.
+/// \param table the table index
+/// \param coordinates one coordinate per table dimension
+/// \return the parameter index, -1 if the coordinates are out of the table range
+Long64_t AliQnCorrectionsCalibrationParameters::FindBin(Int_t table, const Double_t *coordinates) const {
+  Int_t nDimensions = GetNoOfDimensions(table);
+  if (nDimensions == 0) return -1;
+
+  Long64_t index = 0;
+  Long64_t stride = 1;
+  for (Int_t dim = 0; dim < nDimensions; dim++) {
+    Long64_t nBins = GetNoOfBins(table, dim);
+    const Double_t *edges = GetBinEdges(table, dim);
+    if (coordinates[dim] < edges[0] || !(coordinates[dim] < edges[nBins])) return -1;
+    index += TMath::BinarySearch(nBins + 1, edges, coordinates[dim]) * stride;
+    stride *= nBins;
+  }
+  return index;
+}
+
+/// Gets the parameter of a table for a set of coordinates
+/// \param table the table index
+/// \param coordinates one coordinate per table dimension
+/// \return the parameter, zero if the coordinates are out of the table range
+Double_t AliQnCorrectionsCalibrationParameters::GetParameter(Int_t table, const Double_t *coordinates) const {
+  Long64_t bin = FindBin(table, coordinates);
+  const Double_t *parameters = GetParameters(table);
+  if (bin < 0 || parameters == NULL) return 0.0;
+  return parameters[bin];
+}
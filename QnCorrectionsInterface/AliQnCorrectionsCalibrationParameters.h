@@ -0,0 +1,72 @@
+#ifndef ALIQNCORRECTIONS_CALIBRATIONPARAMETERS_H
+#define ALIQNCORRECTIONS_CALIBRATIONPARAMETERS_H
+
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+/// \file AliQnCorrectionsCalibrationParameters.h
+/// \brief Zero copy loader of flat calibration parameter tables
+///
+/// The file, as produced by AliQnCorrectionsCalibrationConverter, is memory
+/// mapped. Opening it does not deserialize anything: the tables bin edges and
+/// parameters are served as pointers into the mapping and the pages are
+/// brought in by the operating system when first touched, shared among all
+/// the processes mapping the same file. As the fields are used in place, the
+/// file has to come from a node with the same byte order. A typical lookup
+///
+///     AliQnCorrectionsCalibrationParameters parameters;
+///     parameters.Open("CalibrationParameters.qncal");
+///     Int_t table = parameters.FindTable(run, "TPC/TPCRecenteringQx");
+///     Double_t coordinates[2] = { centrality, vertexZ };
+///     Double_t meanQx = parameters.GetParameter(table, coordinates);
+
+#include <TObject.h>
+
+#include "AliQnCorrectionsCalibrationConverter.h"
+
+class AliQnCorrectionsCalibrationParameters : public TObject {
+public:
+  AliQnCorrectionsCalibrationParameters();
+  virtual ~AliQnCorrectionsCalibrationParameters();
+
+  Bool_t Open(const char *filename);
+  void Close();
+  Bool_t IsOpen() const { return (fMap != NULL); }
+
+  Int_t GetNoOfTables() const { return fNoOfTables; }
+  Int_t FindTable(Int_t run, const char *path) const;
+  Int_t GetTableRun(Int_t table) const;
+  const char *GetTablePath(Int_t table) const;
+
+  Int_t GetNoOfDimensions(Int_t table) const;
+  Long64_t GetNoOfBins(Int_t table, Int_t dimension) const;
+  const Double_t *GetBinEdges(Int_t table, Int_t dimension) const;
+  Long64_t GetNoOfParameters(Int_t table) const;
+  const Double_t *GetParameters(Int_t table) const;
+
+  Long64_t FindBin(Int_t table, const Double_t *coordinates) const;
+  Double_t GetParameter(Int_t table, const Double_t *coordinates) const;
+
+private:
+  const Char_t *GetTableEntry(Int_t table) const
+    { return fMap + fDirectoryOffset + Long64_t(table) * AliQnCorrectionsCalibrationConverter::fgkTableEntrySize; }
+  ULong64_t GetTableOffset(Int_t table) const;
+
+  const Char_t *fMap;                              //!<! the file mapping. Transient!
+  Long64_t fMapSize;                               //!<! the file mapping size. Transient!
+  Int_t fNoOfTables;                               //!<! the number of tables. Transient!
+  Long64_t fDirectoryOffset;                       //!<! the tables directory offset within the mapping. Transient!
+
+  AliQnCorrectionsCalibrationParameters(const AliQnCorrectionsCalibrationParameters &c);
+  AliQnCorrectionsCalibrationParameters& operator= (const AliQnCorrectionsCalibrationParameters &c);
+
+  ClassDef(AliQnCorrectionsCalibrationParameters, 1);
+};
+
+#endif // ALIQNCORRECTIONS_CALIBRATIONPARAMETERS_H
@@ -0,0 +1,195 @@
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "AliLog.h"
+
+#include "AliQnCorrectionsColumnarReader.h"
+
+ClassImp(AliQnCorrectionsColumnarReader)
+
+/// Default constructor
+AliQnCorrectionsColumnarReader::AliQnCorrectionsColumnarReader() :
+    TObject(),
+    fMap(NULL),
+    fMapSize(0),
+    fNoOfColumns(0),
+    fNoOfRows(0),
+    fNoOfBatches(0),
+    fBatchOffsets(NULL)
+{
+}
+
+/// Default destructor
+/// Releases the file mapping if still there
+AliQnCorrectionsColumnarReader::~AliQnCorrectionsColumnarReader() {
+  Close();
+}
+
+/// Maps the file and checks its header
+/// \param filename the columnar file name
+/// \return kTRUE if the file was properly mapped
+Bool_t AliQnCorrectionsColumnarReader::Open(const char *filename) {
+  Close();
+
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    AliError(Form("Columnar file %s cannot be opened", filename));
+    return kFALSE;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < AliQnCorrectionsColumnarWriter::fgkHeaderSize) {
+    AliError(Form("Columnar file %s is not a columnar Qn vectors file", filename));
+    close(fd);
+    return kFALSE;
+  }
+  void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  /* the mapping stays valid once the descriptor is closed */
+  close(fd);
+  if (map == MAP_FAILED) {
+    AliError(Form("Columnar file %s cannot be mapped", filename));
+    return kFALSE;
+  }
+  fMap = (const Char_t *) map;
+  fMapSize = st.st_size;
+
+  UInt_t version;
+  UInt_t nColumns;
+  ULong64_t nRows;
+  ULong64_t nBatches;
+  ULong64_t directoryOffset;
+  memcpy(&version, fMap + 8, sizeof(UInt_t));
+  memcpy(&nColumns, fMap + 12, sizeof(UInt_t));
+  memcpy(&nRows, fMap + 16, sizeof(ULong64_t));
+  memcpy(&nBatches, fMap + 24, sizeof(ULong64_t));
+  memcpy(&directoryOffset, fMap + 32, sizeof(ULong64_t));
+
+  if (memcmp(fMap, AliQnCorrectionsColumnarWriter::fgkMagic, 8) != 0) {
+    AliError(Form("Columnar file %s is not a columnar Qn vectors file", filename));
+    Close();
+    return kFALSE;
+  }
+  if (version != AliQnCorrectionsColumnarWriter::fgkFormatVersion) {
+    AliError(Form("Columnar file %s format version %u not supported", filename, version));
+    Close();
+    return kFALSE;
+  }
+  if (directoryOffset == 0 ||
+      directoryOffset + nBatches * sizeof(ULong64_t) > (ULong64_t) fMapSize ||
+      AliQnCorrectionsColumnarWriter::fgkHeaderSize + ULong64_t(nColumns) * AliQnCorrectionsColumnarWriter::fgkColumnEntrySize > directoryOffset) {
+    AliError(Form("Columnar file %s was not properly closed", filename));
+    Close();
+    return kFALSE;
+  }
+
+  fNoOfColumns = nColumns;
+  fNoOfRows = nRows;
+  fNoOfBatches = nBatches;
+  fBatchOffsets = (const ULong64_t *) (fMap + directoryOffset);
+  return kTRUE;
+}
+
+/// Releases the file mapping
+void AliQnCorrectionsColumnarReader::Close() {
+  if (fMap != NULL)
+    munmap((void *) fMap, fMapSize);
+  fMap = NULL;
+  fMapSize = 0;
+  fNoOfColumns = 0;
+  fNoOfRows = 0;
+  fNoOfBatches = 0;
+  fBatchOffsets = NULL;
+}
+
+/// Gets the name of a column
+/// \param column the column index
+/// \return the column name, empty if the column is not there
+const char *AliQnCorrectionsColumnarReader::GetColumnName(Int_t column) const {
+  if (column < 0 || !(column < fNoOfColumns)) return "";
+  return GetColumnEntry(column);
+}
+
+/// Gets the type of a column
+/// \param column the column index
+/// \return the column type, -1 if the column is not there
+Int_t AliQnCorrectionsColumnarReader::GetColumnType(Int_t column) const {
+  if (column < 0 || !(column < fNoOfColumns)) return -1;
+  UInt_t type;
+  memcpy(&type, GetColumnEntry(column) + AliQnCorrectionsColumnarWriter::fgkColumnNameLength, sizeof(UInt_t));
+  return type;
+}
+
+/// Gets the element size of a column
+/// \param column the column index
+/// \return the column element size in bytes
+UInt_t AliQnCorrectionsColumnarReader::GetColumnElementSize(Int_t column) const {
+  UInt_t size;
+  memcpy(&size, GetColumnEntry(column) + AliQnCorrectionsColumnarWriter::fgkColumnNameLength + sizeof(UInt_t), sizeof(UInt_t));
+  return size;
+}
+
+/// Finds a column by its name
+/// \param name the column name
+/// \return the column index, -1 if not found
+Int_t AliQnCorrectionsColumnarReader::FindColumn(const char *name) const {
+  for (Int_t column = 0; column < fNoOfColumns; column++) {
+    if (strncmp(GetColumnEntry(column), name, AliQnCorrectionsColumnarWriter::fgkColumnNameLength) == 0)
+      return column;
+  }
+  return -1;
+}
+
+/// Gets the number of rows of a record batch
+/// \param batch the record batch index
+/// \return the number of rows, zero if the record batch is not there
+Long64_t AliQnCorrectionsColumnarReader::GetBatchNoOfRows(Int_t batch) const {
+  if (batch < 0 || !(batch < fNoOfBatches)) return 0;
+  ULong64_t nRows;
+  memcpy(&nRows, fMap + fBatchOffsets[batch], sizeof(ULong64_t));
+  return nRows;
+}
+
+/// Gets the buffer of a column within a record batch
+///
+/// The buffer is within the file mapping, no copy is made. It stays
+/// valid until the reader is closed.
+/// \param batch the record batch index
+/// \param column the column index
+/// \return the column buffer, NULL if not there
+const void *AliQnCorrectionsColumnarReader::GetColumnData(Int_t batch, Int_t column) const {
+  if (batch < 0 || !(batch < fNoOfBatches)) return NULL;
+  if (column < 0 || !(column < fNoOfColumns)) return NULL;
+
+  const Long64_t alignment = AliQnCorrectionsColumnarWriter::fgkAlignment;
+  Long64_t nRows = GetBatchNoOfRows(batch);
+  Long64_t offset = fBatchOffsets[batch] + AliQnCorrectionsColumnarWriter::fgkHeaderSize;
+  for (Int_t previous = 0; previous < column; previous++)
+    offset += ((nRows * GetColumnElementSize(previous) + alignment - 1) / alignment) * alignment;
+
+  if (offset + nRows * GetColumnElementSize(column) > fMapSize) return NULL;
+  return fMap + offset;
+}
+
+/// Gets the buffer of a column within a record batch checking its type
+/// \param batch the record batch index
+/// \param column the column index
+/// \param type the expected column type
+/// \return the column buffer, NULL if not there or of a different type
+const void *AliQnCorrectionsColumnarReader::GetTypedColumnData(Int_t batch, Int_t column, Int_t type) const {
+  if (GetColumnType(column) != type) {
+    AliError(Form("Column %s is not of the requested type", GetColumnName(column)));
+    return NULL;
+  }
+  return GetColumnData(batch, column);
+}
@@ -0,0 +1,80 @@
+#ifndef ALIQNCORRECTIONS_COLUMNARREADER_H
+#define ALIQNCORRECTIONS_COLUMNARREADER_H
+
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+/// \file AliQnCorrectionsColumnarReader.h
+/// \brief Zero copy reader of columnar Qn vector tables
+///
+/// The file, as produced by AliQnCorrectionsColumnarWriter, is memory mapped
+/// and the column buffers of each record batch are served as pointers into
+/// the mapping. A typical scan
+///
+///     AliQnCorrectionsColumnarReader reader;
+///     reader.Open("QnVectorsColumnar.qncol");
+///     Int_t qx = reader.FindColumn("TPC_rec_h2_qx");
+///     for (Int_t batch = 0; batch < reader.GetNoOfBatches(); batch++) {
+///       const Float_t *values = reader.GetFloatColumn(batch, qx);
+///       for (Long64_t row = 0; row < reader.GetBatchNoOfRows(batch); row++)
+///         sum += values[row];
+///     }
+
+#include <TObject.h>
+
+#include "AliQnCorrectionsColumnarWriter.h"
+
+class AliQnCorrectionsColumnarReader : public TObject {
+public:
+  AliQnCorrectionsColumnarReader();
+  virtual ~AliQnCorrectionsColumnarReader();
+
+  Bool_t Open(const char *filename);
+  void Close();
+  Bool_t IsOpen() const { return (fMap != NULL); }
+
+  Int_t GetNoOfColumns() const { return fNoOfColumns; }
+  const char *GetColumnName(Int_t column) const;
+  Int_t GetColumnType(Int_t column) const;
+  Int_t FindColumn(const char *name) const;
+
+  Long64_t GetNoOfRows() const { return fNoOfRows; }
+  Int_t GetNoOfBatches() const { return fNoOfBatches; }
+  Long64_t GetBatchNoOfRows(Int_t batch) const;
+
+  const void *GetColumnData(Int_t batch, Int_t column) const;
+  const Float_t *GetFloatColumn(Int_t batch, Int_t column) const
+    { return (const Float_t *) GetTypedColumnData(batch, column, AliQnCorrectionsColumnarWriter::kFloat); }
+  const Int_t *GetIntColumn(Int_t batch, Int_t column) const
+    { return (const Int_t *) GetTypedColumnData(batch, column, AliQnCorrectionsColumnarWriter::kInt); }
+  const UChar_t *GetUCharColumn(Int_t batch, Int_t column) const
+    { return (const UChar_t *) GetTypedColumnData(batch, column, AliQnCorrectionsColumnarWriter::kUChar); }
+  const Long64_t *GetLong64Column(Int_t batch, Int_t column) const
+    { return (const Long64_t *) GetTypedColumnData(batch, column, AliQnCorrectionsColumnarWriter::kLong64); }
+
+private:
+  const void *GetTypedColumnData(Int_t batch, Int_t column, Int_t type) const;
+  const Char_t *GetColumnEntry(Int_t column) const
+    { return fMap + AliQnCorrectionsColumnarWriter::fgkHeaderSize + Long64_t(column) * AliQnCorrectionsColumnarWriter::fgkColumnEntrySize; }
+  UInt_t GetColumnElementSize(Int_t column) const;
+
+  const Char_t *fMap;                              //!<! the file mapping. Transient!
+  Long64_t fMapSize;                               //!<! the file mapping size. Transient!
+  Int_t fNoOfColumns;                              //!<! the number of columns. Transient!
+  Long64_t fNoOfRows;                              //!<! the number of rows. Transient!
+  Int_t fNoOfBatches;                              //!<! the number of record batches. Transient!
+  const ULong64_t *fBatchOffsets;                  //!<! the record batches directory within the mapping. Transient!
+
+  AliQnCorrectionsColumnarReader(const AliQnCorrectionsColumnarReader &c);
+  AliQnCorrectionsColumnarReader& operator= (const AliQnCorrectionsColumnarReader &c);
+
+  ClassDef(AliQnCorrectionsColumnarReader, 1);
+};
+
+#endif // ALIQNCORRECTIONS_COLUMNARREADER_H
@@ -0,0 +1,229 @@
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+#include <string.h>
+
+#include <TObjString.h>
+#include "AliLog.h"
+
+#include "AliQnCorrectionsColumnarWriter.h"
+
+ClassImp(AliQnCorrectionsColumnarWriter)
+
+const char *AliQnCorrectionsColumnarWriter::fgkMagic = "QNCOLV01";
+
+/// Default constructor
+AliQnCorrectionsColumnarWriter::AliQnCorrectionsColumnarWriter() :
+    TObject(),
+    fColumnNames(),
+    fColumnTypes(),
+    fFile(NULL),
+    fBatchCapacity(0),
+    fBatchNoOfRows(0),
+    fColumnBuffer(NULL),
+    fNoOfRows(0),
+    fFileOffset(0),
+    fBatchOffsets(),
+    fNoOfBatches(0)
+{
+  fColumnNames.SetOwner(kTRUE);
+}
+
+/// Default destructor
+/// Closes the file if still open
+AliQnCorrectionsColumnarWriter::~AliQnCorrectionsColumnarWriter() {
+  Close();
+}
+
+/// Gets the size of an element of a column type
+/// \param type the column type
+/// \return the element size in bytes, zero if the type is not supported
+Int_t AliQnCorrectionsColumnarWriter::GetColumnElementSize(Int_t type) {
+  switch (type) {
+  case kFloat:
+    return sizeof(Float_t);
+  case kInt:
+    return sizeof(Int_t);
+  case kUChar:
+    return sizeof(UChar_t);
+  case kLong64:
+    return sizeof(Long64_t);
+  default:
+    return 0;
+  }
+}
+
+/// Adds a column to the table schema
+///
+/// Columns can only be added before the file is open.
+/// \param name the column name
+/// \param type the column type
+/// \return the column index, -1 if the column could not be added
+Int_t AliQnCorrectionsColumnarWriter::AddColumn(const char *name, ColumnType type) {
+  if (fFile != NULL) {
+    AliError(Form("Column %s cannot be added once the file is open", name));
+    return -1;
+  }
+  if (!(strlen(name) < (UInt_t) fgkColumnNameLength)) {
+    AliError(Form("Column name %s too long. Maximum length: %d", name, fgkColumnNameLength - 1));
+    return -1;
+  }
+  Int_t column = fColumnNames.GetEntriesFast();
+  fColumnNames.Add(new TObjString(name));
+  fColumnTypes.Set(column + 1);
+  fColumnTypes[column] = type;
+  return column;
+}
+
+/// Opens the output file and writes the header and the columns schema
+/// \param filename the output file name
+/// \param batchCapacity the number of rows of a full record batch
+/// \return kTRUE if the file was properly open
+Bool_t AliQnCorrectionsColumnarWriter::Open(const char *filename, Int_t batchCapacity) {
+  if (fFile != NULL) {
+    AliError("The columnar file is already open");
+    return kFALSE;
+  }
+  if (fColumnNames.GetEntriesFast() == 0) {
+    AliError("No columns defined for the columnar file");
+    return kFALSE;
+  }
+
+  fFile = fopen(filename, "wb");
+  if (fFile == NULL) {
+    AliError(Form("Columnar file %s cannot be created", filename));
+    return kFALSE;
+  }
+
+  /* round the capacity so that every full buffer fills complete alignment blocks */
+  fBatchCapacity = ((((batchCapacity < 1) ? 1 : batchCapacity) + fgkAlignment - 1) / fgkAlignment) * fgkAlignment;
+  fBatchNoOfRows = 0;
+  fNoOfRows = 0;
+  fNoOfBatches = 0;
+  fBatchOffsets.Set(0);
+
+  Int_t nColumns = fColumnNames.GetEntriesFast();
+  fColumnBuffer = new Char_t *[nColumns];
+  for (Int_t column = 0; column < nColumns; column++) {
+    fColumnBuffer[column] = new Char_t[fBatchCapacity * GetColumnElementSize(fColumnTypes[column])];
+    memset(fColumnBuffer[column], 0, fBatchCapacity * GetColumnElementSize(fColumnTypes[column]));
+  }
+
+  /* the header counters are left empty until the file is closed */
+  Char_t header[fgkHeaderSize];
+  memset(header, 0, fgkHeaderSize);
+  memcpy(header, fgkMagic, 8);
+  UInt_t version = fgkFormatVersion;
+  UInt_t nCols = nColumns;
+  memcpy(header + 8, &version, sizeof(UInt_t));
+  memcpy(header + 12, &nCols, sizeof(UInt_t));
+  fwrite(header, 1, fgkHeaderSize, fFile);
+
+  for (Int_t column = 0; column < nColumns; column++) {
+    Char_t entry[fgkColumnEntrySize];
+    memset(entry, 0, fgkColumnEntrySize);
+    strncpy(entry, ((TObjString *) fColumnNames.At(column))->GetString().Data(), fgkColumnNameLength - 1);
+    UInt_t type = fColumnTypes[column];
+    UInt_t size = GetColumnElementSize(fColumnTypes[column]);
+    memcpy(entry + fgkColumnNameLength, &type, sizeof(UInt_t));
+    memcpy(entry + fgkColumnNameLength + sizeof(UInt_t), &size, sizeof(UInt_t));
+    fwrite(entry, 1, fgkColumnEntrySize, fFile);
+  }
+  fFileOffset = fgkHeaderSize + Long64_t(nColumns) * fgkColumnEntrySize;
+
+  if (ferror(fFile)) {
+    AliError(Form("Error writing the columnar file %s header", filename));
+    fclose(fFile);
+    fFile = NULL;
+    return kFALSE;
+  }
+  AliInfo(Form("Columnar file %s open with %d columns", filename, nColumns));
+  return kTRUE;
+}
+
+/// Commits the current row and moves to the next one
+///
+/// The current record batch is written once it is full.
+void AliQnCorrectionsColumnarWriter::CommitRow() {
+  fBatchNoOfRows++;
+  fNoOfRows++;
+  if (fBatchNoOfRows == fBatchCapacity)
+    FlushBatch();
+}
+
+/// Writes zeros up to the requested size
+/// \param size the number of bytes to write
+void AliQnCorrectionsColumnarWriter::WritePadding(Long64_t size) {
+  static const Char_t zeros[fgkAlignment] = { 0 };
+  while (size > 0) {
+    Long64_t chunk = (size < fgkAlignment) ? size : fgkAlignment;
+    fwrite(zeros, 1, chunk, fFile);
+    size -= chunk;
+  }
+}
+
+/// Writes the current record batch
+void AliQnCorrectionsColumnarWriter::FlushBatch() {
+  if (fBatchNoOfRows == 0) return;
+
+  if (fNoOfBatches == fBatchOffsets.GetSize())
+    fBatchOffsets.Set((fNoOfBatches == 0) ? 64 : 2 * fNoOfBatches);
+  fBatchOffsets[fNoOfBatches++] = fFileOffset;
+
+  Char_t header[fgkHeaderSize];
+  memset(header, 0, fgkHeaderSize);
+  ULong64_t nRows = fBatchNoOfRows;
+  memcpy(header, &nRows, sizeof(ULong64_t));
+  fwrite(header, 1, fgkHeaderSize, fFile);
+  fFileOffset += fgkHeaderSize;
+
+  for (Int_t column = 0; column < fColumnNames.GetEntriesFast(); column++) {
+    Long64_t size = Long64_t(fBatchNoOfRows) * GetColumnElementSize(fColumnTypes[column]);
+    Long64_t padding = (fgkAlignment - size % fgkAlignment) % fgkAlignment;
+    fwrite(fColumnBuffer[column], 1, size, fFile);
+    WritePadding(padding);
+    fFileOffset += size + padding;
+  }
+  fBatchNoOfRows = 0;
+}
+
+/// Writes the pending rows, the batches directory and the header counters
+/// and closes the file
+void AliQnCorrectionsColumnarWriter::Close() {
+  if (fFile == NULL) return;
+
+  FlushBatch();
+
+  ULong64_t directoryOffset = fFileOffset;
+  for (Int_t batch = 0; batch < fNoOfBatches; batch++) {
+    ULong64_t offset = fBatchOffsets[batch];
+    fwrite(&offset, 1, sizeof(ULong64_t), fFile);
+  }
+
+  ULong64_t nRows = fNoOfRows;
+  ULong64_t nBatches = fNoOfBatches;
+  ULong64_t batchCapacity = fBatchCapacity;
+  fseek(fFile, 16, SEEK_SET);
+  fwrite(&nRows, 1, sizeof(ULong64_t), fFile);
+  fwrite(&nBatches, 1, sizeof(ULong64_t), fFile);
+  fwrite(&directoryOffset, 1, sizeof(ULong64_t), fFile);
+  fwrite(&batchCapacity, 1, sizeof(ULong64_t), fFile);
+
+  if (ferror(fFile))
+    AliError("Error writing the columnar file");
+  fclose(fFile);
+  fFile = NULL;
+
+  AliInfo(Form("Columnar file closed with %lld rows in %d record batches", fNoOfRows, fNoOfBatches));
+
+  for (Int_t column = 0; column < fColumnNames.GetEntriesFast(); column++)
+    delete [] fColumnBuffer[column];
+  delete [] fColumnBuffer;
+  fColumnBuffer = NULL;
+}
@@ -0,0 +1,113 @@
+#ifndef ALIQNCORRECTIONS_COLUMNARWRITER_H
+#define ALIQNCORRECTIONS_COLUMNARWRITER_H
+
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+/// \file AliQnCorrectionsColumnarWriter.h
+/// \brief Writer of columnar, memory mappable, Qn vector tables
+///
+/// The file is a sequence of record batches of fixed width columns. All
+/// the fields are stored little endian, as in the producing node.
+///
+///     file header (64 bytes)
+///       [ 0, 8) magic "QNCOLV01"
+///       [ 8,12) UInt_t    format version
+///       [12,16) UInt_t    number of columns
+///       [16,24) ULong64_t number of rows
+///       [24,32) ULong64_t number of record batches
+///       [32,40) ULong64_t offset of the record batches directory
+///       [40,48) ULong64_t number of rows of a full record batch
+///     columns schema, one 64 bytes entry per column
+///       [ 0,56) column name, NUL terminated
+///       [56,60) UInt_t    column type
+///       [60,64) UInt_t    column element size
+///     record batches, each one
+///       [ 0, 8) ULong64_t number of rows in the batch
+///       [ 8,64) padding
+///       one buffer per column, in schema order, padded to 64 bytes
+///     record batches directory
+///       one ULong64_t offset per record batch
+///
+/// Every buffer starts at a 64 bytes boundary and holds a contiguous
+/// array of values without null entries. This is the layout of an Arrow
+/// primitive array data buffer, so a mapped column can be handed over
+/// to Arrow, or scanned directly, without copying it.
+/// The header counters and the batches directory are only written when
+/// the file is closed.
+
+#include <stdio.h>
+
+#include <TObject.h>
+#include <TObjArray.h>
+#include <TArrayI.h>
+#include <TArrayL64.h>
+
+class AliQnCorrectionsColumnarWriter : public TObject {
+public:
+  /// \enum ColumnType
+  /// \brief The supported column types
+  enum ColumnType {
+    kFloat,      ///< 32 bits floating point
+    kInt,        ///< 32 bits signed integer
+    kUChar,      ///< 8 bits unsigned integer
+    kLong64      ///< 64 bits signed integer
+  };
+
+  AliQnCorrectionsColumnarWriter();
+  virtual ~AliQnCorrectionsColumnarWriter();
+
+  Int_t AddColumn(const char *name, ColumnType type);
+  Bool_t Open(const char *filename, Int_t batchCapacity = 4096);
+  void Close();
+
+  /// Sets the value of a column for the current row
+  /// \param column the column index as returned by AddColumn
+  /// \param value the value
+  void SetFloat(Int_t column, Float_t value) { ((Float_t *) fColumnBuffer[column])[fBatchNoOfRows] = value; }
+  void SetInt(Int_t column, Int_t value) { ((Int_t *) fColumnBuffer[column])[fBatchNoOfRows] = value; }
+  void SetUChar(Int_t column, UChar_t value) { ((UChar_t *) fColumnBuffer[column])[fBatchNoOfRows] = value; }
+  void SetLong64(Int_t column, Long64_t value) { ((Long64_t *) fColumnBuffer[column])[fBatchNoOfRows] = value; }
+  void CommitRow();
+
+  Bool_t IsOpen() const { return (fFile != NULL); }
+  Int_t GetNoOfColumns() const { return fColumnNames.GetEntriesFast(); }
+  Long64_t GetNoOfRows() const { return fNoOfRows; }
+
+  static Int_t GetColumnElementSize(Int_t type);
+
+  static const Int_t fgkAlignment = 64;            ///< the alignment of headers and buffers within the file
+  static const Int_t fgkHeaderSize = 64;           ///< the size of the file and record batch headers
+  static const Int_t fgkColumnEntrySize = 64;      ///< the size of a column schema entry
+  static const Int_t fgkColumnNameLength = 56;     ///< the room for the column name, NUL included
+  static const UInt_t fgkFormatVersion = 1;        ///< the current file format version
+  static const char *fgkMagic;                     ///< the file magic, eight characters
+
+private:
+  void FlushBatch();
+  void WritePadding(Long64_t size);
+
+  TObjArray fColumnNames;                          ///< the columns names
+  TArrayI fColumnTypes;                            ///< the columns types
+  FILE *fFile;                                     //!<! the output file. Transient!
+  Int_t fBatchCapacity;                            //!<! the number of rows of a full record batch. Transient!
+  Int_t fBatchNoOfRows;                            //!<! the number of rows in the current record batch. Transient!
+  Char_t **fColumnBuffer;                          //!<! the current record batch buffer of each column. Transient!
+  Long64_t fNoOfRows;                              //!<! the number of rows written. Transient!
+  Long64_t fFileOffset;                            //!<! the current file write offset. Transient!
+  TArrayL64 fBatchOffsets;                         //!<! the file offset of each record batch. Transient!
+  Int_t fNoOfBatches;                              //!<! the number of record batches written. Transient!
+
+  AliQnCorrectionsColumnarWriter(const AliQnCorrectionsColumnarWriter &c);
+  AliQnCorrectionsColumnarWriter& operator= (const AliQnCorrectionsColumnarWriter &c);
+
+  ClassDef(AliQnCorrectionsColumnarWriter, 1);
+};
+
+#endif // ALIQNCORRECTIONS_COLUMNARWRITER_H
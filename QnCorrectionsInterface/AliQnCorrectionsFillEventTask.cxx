@@ -43,10 +43,16 @@
 #include "AliQnCorrectionsManager.h"
 
 #include "AliQnCorrectionsHistos.h"
+#include "AliQnCorrectionsCutsSet.h"
 
 #include <TChain.h>
 #include <TH1D.h>
 #include <TFile.h>
+#include <TObjString.h>
+#include <TObjArray.h>
+#include <TMath.h>
+#include <TClonesArray.h>
+#include <TClass.h>
 
 #include <AliInputEventHandler.h>
 #include <AliAnalysisManager.h>
@@ -67,6 +73,7 @@
 #include <AliESDHeader.h>
 #include <AliESDtrack.h>
 #include <AliESDtrackCuts.h>
+#include <AliESDVertex.h>
 #include <AliESDFMD.h>
 
 #include <AliAODInputHandler.h>
@@ -90,8 +97,13 @@ fEvent(NULL),
 fAliQnCorrectionsManager(NULL),
 fEventHistos(NULL),
 fDataBank(NULL),
+fFillTrackQA(kTRUE),
 fUseOnlyCentCalibEvents(kTRUE),
 fUseTPCStandaloneTracks(kFALSE),
+fDemandDrivenTrackVariables(kFALSE),
+fTrackVariablesUsedByCuts(""),
+fSortedRunNumbers(),
+fSortedRunIndices(),
 fFillVZERO(kFALSE),
 fFillTPC(kFALSE),
 fFillZDC(kFALSE),
@@ -100,12 +112,31 @@ fFillFMD(kFALSE),
 fFillRawFMD(kFALSE),
 fFillSPD(kFALSE),
 fIsAOD(kFALSE),
-fIsESD(kFALSE)
+fIsESD(kFALSE),
+fInputEventFormat(INPUTFMT_unknown),
+fESDEvent(NULL),
+fAODEvent(NULL),
+fRunIndexRunNumber(-1),
+fRunIndex(-1),
+fRawFMDStripGeometryBuilt(kFALSE),
+fRawFMDStripPhi(NULL),
+fRawFMDStripSectorId(NULL),
+fRawFMDRingStripEta(NULL),
+fNoOfUnextractedTrackVariables(0),
+fForwardMult(NULL),
+fFMDNoOfEtaBins(0),
+fFMDNoOfPhiBins(0),
+fFMDPhiBinCenter(NULL),
+fFMDSelectedBins(NULL),
+fTPCOnlyTracksArena(NULL),
+fNoOfTPCOnlyTracksInArena(0)
 {
   //
   // Default constructor
   //
 
+  for (Int_t var = 0; var < kNVars; var++) fTrackVariablesMask[var] = kTRUE;
+  for (Int_t var = 0; var < kNVars; var++) fUnextractedTrackVariables[var] = -1;
 }
 
 AliQnCorrectionsFillEventTask::AliQnCorrectionsFillEventTask(const char *name) :
@@ -114,8 +145,13 @@ fEvent(NULL),
 fAliQnCorrectionsManager(NULL),
 fEventHistos(NULL),
 fDataBank(NULL),
+fFillTrackQA(kTRUE),
 fUseOnlyCentCalibEvents(kTRUE),
 fUseTPCStandaloneTracks(kFALSE),
+fDemandDrivenTrackVariables(kFALSE),
+fTrackVariablesUsedByCuts(""),
+fSortedRunNumbers(),
+fSortedRunIndices(),
 fFillVZERO(kFALSE),
 fFillTPC(kFALSE),
 fFillZDC(kFALSE),
@@ -124,12 +160,31 @@ fFillFMD(kFALSE),
 fFillRawFMD(kFALSE),
 fFillSPD(kFALSE),
 fIsAOD(kFALSE),
-fIsESD(kFALSE)
+fIsESD(kFALSE),
+fInputEventFormat(INPUTFMT_unknown),
+fESDEvent(NULL),
+fAODEvent(NULL),
+fRunIndexRunNumber(-1),
+fRunIndex(-1),
+fRawFMDStripGeometryBuilt(kFALSE),
+fRawFMDStripPhi(NULL),
+fRawFMDStripSectorId(NULL),
+fRawFMDRingStripEta(NULL),
+fNoOfUnextractedTrackVariables(0),
+fForwardMult(NULL),
+fFMDNoOfEtaBins(0),
+fFMDNoOfPhiBins(0),
+fFMDPhiBinCenter(NULL),
+fFMDSelectedBins(NULL),
+fTPCOnlyTracksArena(NULL),
+fNoOfTPCOnlyTracksInArena(0)
 {
   //
   // Default constructor
   //
 
+  for (Int_t var = 0; var < kNVars; var++) fTrackVariablesMask[var] = kTRUE;
+  for (Int_t var = 0; var < kNVars; var++) fUnextractedTrackVariables[var] = -1;
 }
 
 
@@ -139,6 +194,73 @@ AliQnCorrectionsFillEventTask::~AliQnCorrectionsFillEventTask()
   //
   // Destructor
   //
+  delete [] fRawFMDStripPhi;
+  delete [] fRawFMDStripSectorId;
+  delete [] fRawFMDRingStripEta;
+  delete fTPCOnlyTracksArena;
+  delete [] fFMDPhiBinCenter;
+  delete [] fFMDSelectedBins;
+}
+
+//_____________________________________________________________________________
+/// A new input file is going to be processed
+///
+/// The cached AOD forward multiplicity object could belong to the
+/// previous input tree so it is invalidated.
+Bool_t AliQnCorrectionsFillEventTask::Notify()
+{
+  InvalidateFMDCache();
+  return AliQnCorrectionsVarManagerTask::Notify();
+}
+
+//_____________________________________________________________________________
+/// Sets the runs list the run indexed histograms axes are built on
+///
+/// The run axes have one bin per run in the list, in the list order,
+/// labelled with the run number. Jobs configured with the same list
+/// produce the same axes whatever runs they actually process, so their
+/// outputs merge bin by bin. The run numbers are kept sorted for a binary
+/// search of the run index.
+/// \param runsList the list of runs as TObjString with the run number
+void AliQnCorrectionsFillEventTask::SetRunsList(const TObjArray *runsList)
+{
+  Int_t nRuns = (runsList != NULL) ? runsList->GetEntriesFast() : 0;
+  TArrayI runNumbers(nRuns);
+  for (Int_t i = 0; i < nRuns; i++)
+    runNumbers[i] = ((TObjString *) runsList->At(i))->GetString().Atoi();
+
+  fSortedRunNumbers.Set(nRuns);
+  fSortedRunIndices.Set(nRuns);
+  if (nRuns > 0)
+    TMath::Sort(nRuns, runNumbers.GetArray(), fSortedRunIndices.GetArray(), kFALSE);
+  for (Int_t i = 0; i < nRuns; i++)
+    fSortedRunNumbers[i] = runNumbers[fSortedRunIndices[i]];
+
+  fRunIndexRunNumber = -1;
+  fRunIndex = -1;
+}
+
+//_____________________________________________________________________________
+/// Gets the position of a run in the configured runs list
+///
+/// The index is only searched when the run changes.
+/// \param runNumber the run number
+/// \return the run index, -1 if the run is not in the list
+Int_t AliQnCorrectionsFillEventTask::GetRunIndex(Int_t runNumber)
+{
+  if (runNumber == fRunIndexRunNumber) return fRunIndex;
+
+  fRunIndexRunNumber = runNumber;
+  fRunIndex = -1;
+  Int_t nRuns = fSortedRunNumbers.GetSize();
+  if (nRuns > 0) {
+    Long64_t pos = TMath::BinarySearch(nRuns, fSortedRunNumbers.GetArray(), runNumber);
+    if (pos >= 0 && fSortedRunNumbers[pos] == runNumber)
+      fRunIndex = fSortedRunIndices[pos];
+  }
+  if (fRunIndex < 0 && nRuns > 0)
+    AliWarning(Form("Run %d is not in the configured runs list. It goes to the run axes underflow", runNumber));
+  return fRunIndex;
 }
 
 
@@ -157,14 +279,142 @@ void AliQnCorrectionsFillEventTask::SetDetectors() {
 }
 
 
+//__________________________________________________________________
+/// Builds the mask of track variables to extract for each track
+///
+/// When demand driven extraction is enabled only the track variables
+/// used by the event histograms or by the registered detector
+/// configurations cuts are extracted, otherwise all of them are.
+/// The track variables not extracted are set to NaN for each event so
+/// that a cut on a variable not extracted rejects every track instead
+/// of silently using a stale value. As that would happen with every TPC
+/// cut if its cuts were not registered, the task is aborted then.
+/// Must be called once the histograms and the detectors have been defined.
+void AliQnCorrectionsFillEventTask::BuildTrackVariablesMask() {
+
+  fNoOfUnextractedTrackVariables = 0;
+  for (Int_t var = 0; var < kNVars; var++) fTrackVariablesMask[var] = !fDemandDrivenTrackVariables;
+  if (!fDemandDrivenTrackVariables) return;
+
+  const Bool_t *histosUsedVars = (fEventHistos != NULL) ? fEventHistos->GetUsedVars() : NULL;
+  if (histosUsedVars == NULL) {
+    AliWarning("The histograms used variables are not available. Extracting all track variables");
+    for (Int_t var = 0; var < kNVars; var++) fTrackVariablesMask[var] = kTRUE;
+    return;
+  }
+  for (Int_t var = kNEventVars; var < kNVars; var++) fTrackVariablesMask[var] = histosUsedVars[var];
+
+  if (fFillTPC && fTrackVariablesUsedByCuts.Length() == 0)
+    AliFatal("Demand driven track variables without the TPC cuts registered with AddTrackVariablesUsedByCuts. "
+        "Every track would be rejected. Register them or disable SetDemandDrivenTrackVariables");
+
+  TObjArray *tokens = fTrackVariablesUsedByCuts.Tokenize(";");
+  for (Int_t i = 0; i < tokens->GetEntriesFast(); i++) {
+    Int_t var = ((TObjString *) tokens->At(i))->GetString().Atoi();
+    if ((!(var < 0)) && (var < kNVars)) fTrackVariablesMask[var] = kTRUE;
+  }
+  delete tokens;
+
+  /* the derived variables need the ones they are built from */
+  if (fTrackVariablesMask[kTPCchi2]) fTrackVariablesMask[kTPCncls] = kTRUE;
+  if (fTrackVariablesMask[kTPCchi2Iter1]) fTrackVariablesMask[kTPCnclsIter1] = kTRUE;
+
+  TString szUsedVars = "";
+  for (Int_t var = kNEventVars; var < kNVars; var++) {
+    if (fTrackVariablesMask[var])
+      szUsedVars += Form(" %s", VarName(var));
+    else
+      fUnextractedTrackVariables[fNoOfUnextractedTrackVariables++] = var;
+  }
+  AliInfo(Form("Track variables to extract:%s", szUsedVars.Data()));
+}
+
+//__________________________________________________________________
+/// Registers the variables used by a detector configuration cuts set
+///
+/// The variables are taken from the cuts themselves so that they cannot
+/// get out of sync with them. Needed, with demand driven track variables,
+/// for every cuts set given to a track detector configuration.
+/// \param cuts the cuts set
+void AliQnCorrectionsFillEventTask::AddTrackVariablesUsedByCuts(const AliQnCorrectionsCutsSet *cuts) {
+
+  for (Int_t i = 0; i < cuts->GetEntriesFast(); i++) {
+    const TObject *cut = cuts->At(i);
+    /* the cuts do not expose their variable, it is taken through their dictionary */
+    Long_t offset = cut->IsA()->GetDataMemberOffset("fVarId");
+    if (offset == 0)
+      AliFatal(Form("The variable of the cut %s is not known. Demand driven track variables cannot be used", cut->ClassName()));
+    fTrackVariablesUsedByCuts += *((const Int_t *) (((const char *) cut) + offset));
+    fTrackVariablesUsedByCuts += ";";
+  }
+}
+
+//__________________________________________________________________
+/// Sets the track variables not extracted to NaN
+///
+/// They are never written by the track extraction so it is only
+/// needed once per event, when the data bank has been cleared.
+void AliQnCorrectionsFillEventTask::ResetUnextractedTrackVariables() {
+
+  for (Int_t i = 0; i < fNoOfUnextractedTrackVariables; i++)
+    fDataBank[fUnextractedTrackVariables[i]] = TMath::QuietNaN();
+}
+
+//__________________________________________________________________
+/// Gets a TPC only track from the per event arena
+///
+/// Equivalent to AliESDtrackCuts::GetTPCOnlyTrack but the TPC only track
+/// is built on a track object owned by the arena which is reused in the
+/// next events instead of being allocated and deleted track by track.
+/// The reused track is reset before being filled, as a new one would be.
+/// The returned track is valid until the arena is reset at the beginning
+/// of the next event and must not be deleted.
+/// The validity of the TPC primary vertex should be checked by the caller.
+/// \param esdTrack the ESD track to extract the TPC only track from
+/// \return the TPC only track, NULL if the track has no TPC information
+AliESDtrack *AliQnCorrectionsFillEventTask::GetTPCOnlyTrackFromArena(AliESDtrack *esdTrack) {
+
+  if (fTPCOnlyTracksArena == NULL) fTPCOnlyTracksArena = new TClonesArray("AliESDtrack", 4096);
+
+  AliESDtrack *tpcTrack = static_cast<AliESDtrack *>(fTPCOnlyTracksArena->ConstructedAt(fNoOfTPCOnlyTracksInArena));
+  /* the arena track could keep fields of a previous one FillTPCOnlyTrack does not set */
+  *tpcTrack = AliESDtrack();
+  if (!esdTrack->FillTPCOnlyTrack(*tpcTrack)) return NULL;
+
+  fNoOfTPCOnlyTracksInArena++;
+  return tpcTrack;
+}
+
+//__________________________________________________________________
+/// Resolves the input event format
+///
+/// The format does not change along the analysis so it is resolved
+/// once from the input event instead of on each event.
+void AliQnCorrectionsFillEventTask::ResolveInputEventFormat() {
+
+  AliVEvent *event = InputEvent();
+  if (event == NULL) return;
+
+  if (event->InheritsFrom(AliESDEvent::Class()))
+    fInputEventFormat = INPUTFMT_ESD;
+  else if (event->InheritsFrom(AliAODEvent::Class()))
+    fInputEventFormat = INPUTFMT_AOD;
+  else {
+    AliError(Form("Input event format %s not supported", event->ClassName()));
+    return;
+  }
+
+  fIsESD = (fInputEventFormat == INPUTFMT_ESD);
+  fIsAOD = (fInputEventFormat == INPUTFMT_AOD);
+}
+
 //__________________________________________________________________
 void AliQnCorrectionsFillEventTask::FillEventData() {
 
-  TString aod = "AOD";
-  TString esd = "ESD";
+  if (fInputEventFormat == INPUTFMT_unknown) ResolveInputEventFormat();
 
-  fIsAOD = ( aod.EqualTo(fEvent->Whoami()) ? kTRUE : kFALSE );
-  fIsESD = ( esd.EqualTo(fEvent->Whoami()) ? kTRUE : kFALSE );
+  fESDEvent = fIsESD ? static_cast<AliESDEvent*>(fEvent) : NULL;
+  fAODEvent = fIsAOD ? static_cast<AliAODEvent*>(fEvent) : NULL;
 
   FillEventInfo();
   FillDetectors();
@@ -178,6 +428,7 @@ void AliQnCorrectionsFillEventTask::FillEventInfo() {
 
 
   fDataBank[kRunNo]       = fEvent->GetRunNumber();
+  fDataBank[kRunIndex]    = GetRunIndex(fEvent->GetRunNumber());
   fDataBank[kVtxX]        = -999.;
   fDataBank[kVtxY]        = -999.;
   fDataBank[kVtxZ]        = -999.;
@@ -192,8 +443,7 @@ void AliQnCorrectionsFillEventTask::FillEventInfo() {
   AliMultSelection *MultSelection = (AliMultSelection * ) fEvent->FindListObject("MultSelection");
   if(MultSelection) fDataBank[kVZEROMultPercentile] = MultSelection->GetMultiplicityPercentile("V0M", fUseOnlyCentCalibEvents);
 
-  AliESDEvent* esdEvent = static_cast<AliESDEvent*>(fEvent);
-  AliCentrality* cent = esdEvent->GetCentrality();
+  AliCentrality* cent = fEvent->GetCentrality();
   if(cent){
     fDataBank[kCentVZERO]   = cent->GetCentralityPercentile("V0M");
     fDataBank[kCentSPD]     = cent->GetCentralityPercentile("CL1");
@@ -217,29 +467,32 @@ void AliQnCorrectionsFillEventTask::FillEventInfo() {
 //__________________________________________________________________
 void AliQnCorrectionsFillEventTask::FillTrackInfo(AliVParticle* particle) {
 
-  Float_t dcaxy=0.0;
-  Float_t dcaz=0.0;
-
-  fDataBank[kPx]        = particle->Px();
-  fDataBank[kPy]        = particle->Py();
-  fDataBank[kPz]        = particle->Pz();
-  fDataBank[kPt]        = particle->Pt();
-  fDataBank[kP]         = particle->P();
-  fDataBank[kPhi]       = particle->Phi();
-  fDataBank[kTheta]     = particle->Theta();
-  fDataBank[kEta]       = particle->Eta();
-  fDataBank[kCharge]    = particle->Charge();
-  fDataBank[kDcaXY]     = dcaxy;
-  fDataBank[kDcaZ]      = dcaz;
+  const Bool_t *used = fTrackVariablesMask;
+
+  if (used[kPx])        fDataBank[kPx]        = particle->Px();
+  if (used[kPy])        fDataBank[kPy]        = particle->Py();
+  if (used[kPz])        fDataBank[kPz]        = particle->Pz();
+  if (used[kPt])        fDataBank[kPt]        = particle->Pt();
+  if (used[kP])         fDataBank[kP]         = particle->P();
+  if (used[kPhi])       fDataBank[kPhi]       = particle->Phi();
+  if (used[kTheta])     fDataBank[kTheta]     = particle->Theta();
+  if (used[kEta])       fDataBank[kEta]       = particle->Eta();
+  if (used[kCharge])    fDataBank[kCharge]    = particle->Charge();
+  if (used[kDcaXY])     fDataBank[kDcaXY]     = 0.0;
+  if (used[kDcaZ])      fDataBank[kDcaZ]      = 0.0;
 
   AliAODTrack* aodTrack=static_cast<AliAODTrack*>(particle);
 
   //fDataBank[VAR::kITSncls]       = particle->GetNcls(0);
-  fDataBank[kTPCncls]       = aodTrack->GetTPCNcls();
-  fDataBank[kTPCchi2]       = aodTrack->Chi2perNDF();
-  fDataBank[kTPCsignal]     = aodTrack->GetTPCsignal();
-  for(Int_t ibit=0; ibit<9; ibit++) fDataBank[kFilterBit+ibit]     = aodTrack->TestFilterBit(BIT(ibit));
-  fDataBank[kFilterBitMask768]  = (aodTrack->TestFilterBit(BIT(8))||aodTrack->TestFilterBit(BIT(9)));
+  if (used[kTPCncls])   fDataBank[kTPCncls]       = aodTrack->GetTPCNcls();
+  if (used[kTPCchi2])   fDataBank[kTPCchi2]       = aodTrack->Chi2perNDF();
+  if (used[kTPCsignal]) fDataBank[kTPCsignal]     = aodTrack->GetTPCsignal();
+
+  /* the filter bits are read once as a packed mask */
+  UInt_t filterMap = aodTrack->GetFilterMap();
+  for(Int_t ibit=0; ibit<9; ibit++)
+    if (used[kFilterBit+ibit]) fDataBank[kFilterBit+ibit]     = ((filterMap & BIT(ibit)) != 0);
+  if (used[kFilterBitMask768]) fDataBank[kFilterBitMask768]  = ((filterMap & (BIT(8) | BIT(9))) != 0);
 
 }
 
@@ -247,27 +500,31 @@ void AliQnCorrectionsFillEventTask::FillTrackInfo(AliVParticle* particle) {
 //__________________________________________________________________
 void AliQnCorrectionsFillEventTask::FillTrackInfo(AliESDtrack* particle) {
 
-  Float_t dcaxy=0.0;
-  Float_t dcaz=0.0;
-  particle->GetImpactParameters(dcaxy,dcaz);
+  const Bool_t *used = fTrackVariablesMask;
+
+  if (used[kDcaXY] || used[kDcaZ]) {
+    Float_t dcaxy=0.0;
+    Float_t dcaz=0.0;
+    particle->GetImpactParameters(dcaxy,dcaz);
+    fDataBank[kDcaXY]     = dcaxy;
+    fDataBank[kDcaZ]      = dcaz;
+  }
 
-  fDataBank[kPx]        = particle->Px();
-  fDataBank[kPy]        = particle->Py();
-  fDataBank[kPz]        = particle->Pz();
-  fDataBank[kPt]        = particle->Pt();
-  fDataBank[kP]         = particle->P();
-  fDataBank[kPhi]       = particle->Phi();
-  fDataBank[kTheta]     = particle->Theta();
-  fDataBank[kEta]       = particle->Eta();
-  fDataBank[kCharge]    = particle->Charge();
-  fDataBank[kDcaXY]     = dcaxy;
-  fDataBank[kDcaZ]      = dcaz;
+  if (used[kPx])        fDataBank[kPx]        = particle->Px();
+  if (used[kPy])        fDataBank[kPy]        = particle->Py();
+  if (used[kPz])        fDataBank[kPz]        = particle->Pz();
+  if (used[kPt])        fDataBank[kPt]        = particle->Pt();
+  if (used[kP])         fDataBank[kP]         = particle->P();
+  if (used[kPhi])       fDataBank[kPhi]       = particle->Phi();
+  if (used[kTheta])     fDataBank[kTheta]     = particle->Theta();
+  if (used[kEta])       fDataBank[kEta]       = particle->Eta();
+  if (used[kCharge])    fDataBank[kCharge]    = particle->Charge();
 
-  fDataBank[kTPCncls]       = particle->GetTPCNcls();
-  fDataBank[kTPCnclsIter1]  = particle->GetTPCNclsIter1();
-  fDataBank[kTPCchi2]       = fDataBank[kTPCncls]>0 ? particle->GetTPCchi2()/fDataBank[kTPCncls] : 0.0;
-  fDataBank[kTPCchi2Iter1]  = fDataBank[kTPCnclsIter1]>0 ? particle->GetTPCchi2Iter1()/fDataBank[kTPCnclsIter1] : 0.0;
-  fDataBank[kTPCsignal]     = particle->GetTPCsignal();
+  if (used[kTPCncls])       fDataBank[kTPCncls]       = particle->GetTPCNcls();
+  if (used[kTPCnclsIter1])  fDataBank[kTPCnclsIter1]  = particle->GetTPCNclsIter1();
+  if (used[kTPCchi2])       fDataBank[kTPCchi2]       = fDataBank[kTPCncls]>0 ? particle->GetTPCchi2()/fDataBank[kTPCncls] : 0.0;
+  if (used[kTPCchi2Iter1])  fDataBank[kTPCchi2Iter1]  = fDataBank[kTPCnclsIter1]>0 ? particle->GetTPCchi2Iter1()/fDataBank[kTPCnclsIter1] : 0.0;
+  if (used[kTPCsignal])     fDataBank[kTPCsignal]     = particle->GetTPCsignal();
 
 
 
@@ -311,10 +568,12 @@ void AliQnCorrectionsFillEventTask::FillAodTPC(){
     if (!vTrack) continue;
 
     FillTrackInfo(vTrack);
-    fEventHistos->FillHistClass("TrackQA_NoCuts", fDataBank);
+    if (fFillTrackQA) fEventHistos->FillHistClass("TrackQA_NoCuts", fDataBank);
 
     Int_t nNoOfAcceptedConf = fAliQnCorrectionsManager->AddDataVector(kTPC, vTrack->Phi());
 
+    if (!fFillTrackQA) continue;
+
     for(Int_t conf=0; conf < nNoOfAcceptedConf; conf++){
         fEventHistos->FillHistClass(Form("TrackQA_%s",
             fAliQnCorrectionsManager->GetAcceptedDataDetectorConfigurationName(kTPC, conf)),
@@ -334,29 +593,32 @@ void AliQnCorrectionsFillEventTask::FillEsdTPC(){
 
   AliESDtrack* esdTrack;
 
-  const AliESDEvent* esdEvent = static_cast<AliESDEvent*>(fEvent);
-  const AliESDEvent& esd = *esdEvent;
+  const AliESDEvent& esd = *fESDEvent;
+
+  /* no TPC vertex no TPC only tracks */
+  const AliESDVertex *tpcVertex = esd.GetPrimaryVertexTPC();
+  Bool_t bTPCOnlyTracks = (tpcVertex != NULL) && tpcVertex->GetStatus();
 
   for (Int_t iTrack = 0; iTrack < fEvent->GetNumberOfTracks(); ++iTrack)
   {
     AliESDtrack* track = NULL;
     esdTrack = esd.GetTrack(iTrack); //carefull do not modify it othwise  need to work with a copy 
-    if(fUseTPCStandaloneTracks) track = AliESDtrackCuts::GetTPCOnlyTrack(const_cast<AliESDEvent*>(&esd),esdTrack->GetID());
+    if(fUseTPCStandaloneTracks) track = bTPCOnlyTracks ? GetTPCOnlyTrackFromArena(esdTrack) : NULL;
     else track = esdTrack;
     if (!track) continue;
 
     FillTrackInfo(track);
-    fEventHistos->FillHistClass("TrackQA_NoCuts", fDataBank);
+    if (fFillTrackQA) fEventHistos->FillHistClass("TrackQA_NoCuts", fDataBank);
 
     Int_t nNoOfAcceptedConf = fAliQnCorrectionsManager->AddDataVector(kTPC, track->Phi());
 
+    if (!fFillTrackQA) continue;
+
     for(Int_t conf=0; conf < nNoOfAcceptedConf; conf++){
         fEventHistos->FillHistClass(Form("TrackQA_%s",
             fAliQnCorrectionsManager->GetAcceptedDataDetectorConfigurationName(kTPC, conf)),
             fDataBank);
     }
-
-    if(fUseTPCStandaloneTracks) delete track;
   }
 }
 
@@ -378,6 +640,8 @@ void AliQnCorrectionsFillEventTask::FillSPDTracklets() {
 
     Int_t nNoOfAcceptedConf = fAliQnCorrectionsManager->AddDataVector(kSPD, fDataBank[kSPDtrackletPhi]);
 
+    if (!fFillTrackQA) continue;
+
     for(Int_t conf=0; conf < nNoOfAcceptedConf; conf++){
       fEventHistos->FillHistClass(Form("TrackletQA_%s",
           fAliQnCorrectionsManager->GetAcceptedDataDetectorConfigurationName(kSPD, conf)),
@@ -386,21 +650,75 @@ void AliQnCorrectionsFillEventTask::FillSPDTracklets() {
   }
 }
 
+/* detector channel tables, built once when the library is loaded and shared by the fill functions */
+static const Int_t nVZEROChannels = 64;
+static const Int_t nVZEROChannelsPerRing = 8;
+static const Int_t nTZEROChannels = 24;
+static const Int_t nZDCChannels = 10;
+static const Int_t nZDCTowers = 8;   /* the non common towers */
+
+/// The TZERO channels position
+static const Double_t tzeroChannelX[nTZEROChannels] = {
+    /* Cside */ 0.905348,0.571718,0.0848977,-0.424671,-0.82045,-0.99639,-0.905348,-0.571718,-0.0848977,0.424671,0.82045,0.99639,
+    /* Aside */ 0.99995,0.870982,0.508635,0.00999978,-0.491315,-0.860982,-0.99995,-0.870982,-0.508635,-0.0100001,0.491315,0.860982};
+static const Double_t tzeroChannelY[nTZEROChannels] = {
+    /* Cside */ 0.424671,0.82045,0.99639,0.905348,0.571718,0.0848976,-0.424671,-0.82045,-0.99639,-0.905348,-0.571719,-0.0848975,
+    /* Aside */ -0.00999983,0.491315,0.860982,0.99995,0.870982,0.508635,0.00999974,-0.491315,-0.860982,-0.99995,-0.870982,-0.508635};
+
+/// The ZDC towers position
+static const Double_t zdcChannelX[nZDCChannels] = { /* Cside */ 0.0,  -1.75,  1.75, -1.75, 1.75,
+                                                    /* Aside */  0.0,  1.75, -1.75, 1.75, -1.75  };
+static const Double_t zdcChannelY[nZDCChannels] = { /* Cside */ 0.0,  -1.75, -1.75,  1.75, 1.75,
+                                                    /* Aside */  0.0, -1.75, -1.75, 1.75,  1.75  };
+
+/// \class QnChannelTables
+/// \brief The azimuthal angle and channel id of the detectors with a fixed channel layout
+///
+/// The per event channel loops only need to look the values up.
+class QnChannelTables {
+public:
+  QnChannelTables();
+
+  Double_t fVZEROPhi[nVZEROChannels];    ///< the VZERO channels azimuthal angle
+  Double_t fTZEROPhi[nTZEROChannels];    ///< the TZERO channels azimuthal angle
+  Double_t fZDCPhi[nZDCChannels];        ///< the ZDC channels azimuthal angle
+  Int_t fZDCTowerId[nZDCTowers];         ///< the ZDC non common towers channel id
+};
+
+QnChannelTables::QnChannelTables() {
+
+  for (Int_t ich = 0; ich < nVZEROChannels; ich++)
+    fVZEROPhi[ich] = (2 * (ich % nVZEROChannelsPerRing) + 1) * TMath::Pi() / 8.0;
+
+  for (Int_t ich = 0; ich < nTZEROChannels; ich++)
+    fTZEROPhi[ich] = TMath::ATan2(tzeroChannelY[ich], tzeroChannelX[ich]);
+
+  Int_t tower = 0;
+  for (Int_t ich = 0; ich < nZDCChannels; ich++) {
+    if ((ich == 0) || (ich == 5)) {
+      fZDCPhi[ich] = 0.0;
+      continue;
+    }
+    fZDCPhi[ich] = TMath::ATan2(zdcChannelY[ich], zdcChannelX[ich]);
+    fZDCTowerId[tower++] = ich;
+  }
+}
+
+static const QnChannelTables channelTables;
+
 void AliQnCorrectionsFillEventTask::FillVZERO(){
   //
   // fill VZERO info
   //
 
   Double_t weight=0.;
-  static const Double_t phi[8] = {1*TMath::Pi()/8.0, 3*TMath::Pi()/8.0, 5*TMath::Pi()/8.0, 7*TMath::Pi()/8.0,
-      9*TMath::Pi()/8.0, 11*TMath::Pi()/8.0, 13*TMath::Pi()/8.0, 15*TMath::Pi()/8.0};
 
   AliVVZERO* vzero = fEvent->GetVZEROData();
 
-  for(Int_t ich=0; ich<64; ich++){
+  for(Int_t ich=0; ich<nVZEROChannels; ich++){
     weight=vzero->GetMultiplicity(ich);
     if(weight > fVZEROSignalThreshold) {
-      fAliQnCorrectionsManager->AddDataVector(kVZERO, phi[ich%8], weight, ich);   // 1st ich is position in array, 2nd ich is channel id
+      fAliQnCorrectionsManager->AddDataVector(kVZERO, channelTables.fVZEROPhi[ich], weight, ich);   // 1st ich is position in array, 2nd ich is channel id
     }
   }
 }
@@ -413,24 +731,12 @@ void AliQnCorrectionsFillEventTask::FillTZERO(){
   //
 
   Double_t weight=0.0;
-  const Double_t kX[24] = {/* Cside */ 0.905348,0.571718,0.0848977,-0.424671,-0.82045,-0.99639,-0.905348,-0.571718,-0.0848977,0.424671,0.82045,0.99639,
-                           /* Aside */ 0.99995,0.870982,0.508635,0.00999978,-0.491315,-0.860982,-0.99995,-0.870982,-0.508635,-0.0100001,0.491315,0.860982};
-  const Double_t kY[24] = {/* Cside */ 0.424671,0.82045,0.99639,0.905348,0.571718,0.0848976,-0.424671,-0.82045,-0.99639,-0.905348,-0.571719,-0.0848975,
-                           /* Aside */ -0.00999983,0.491315,0.860982,0.99995,0.870982,0.508635,0.00999974,-0.491315,-0.860982,-0.99995,-0.870982,-0.508635};
-  const Double_t phi[24] = {TMath::ATan2(kY[0],kX[0]), TMath::ATan2(kY[1],kX[1]), TMath::ATan2(kY[2],kX[2]),
-      TMath::ATan2(kY[3],kX[3]), TMath::ATan2(kY[4],kX[4]), TMath::ATan2(kY[5],kX[5]),
-      TMath::ATan2(kY[6],kX[6]), TMath::ATan2(kY[7],kX[7]),
-      TMath::ATan2(kY[8],kX[8]), TMath::ATan2(kY[9],kX[9]), TMath::ATan2(kY[10],kX[10]),
-      TMath::ATan2(kY[11],kX[11]), TMath::ATan2(kY[12],kX[12]), TMath::ATan2(kY[13],kX[13]),
-      TMath::ATan2(kY[14],kX[14]), TMath::ATan2(kY[15],kX[15]),
-      TMath::ATan2(kY[16],kX[16]), TMath::ATan2(kY[17],kX[17]), TMath::ATan2(kY[18],kX[18]),
-      TMath::ATan2(kY[19],kX[19]), TMath::ATan2(kY[20],kX[20]), TMath::ATan2(kY[21],kX[21]),
-      TMath::ATan2(kY[22],kX[22]), TMath::ATan2(kY[23],kX[23]) };
+  const Double_t *phi = channelTables.fTZEROPhi;
 
   if (fIsESD) {
-    const AliESDTZERO* esdT0 = dynamic_cast<AliESDEvent*>(fEvent)->GetESDTZERO();
+    const AliESDTZERO* esdT0 = fESDEvent->GetESDTZERO();
     if (esdT0 != NULL) {
-      for(Int_t ich=0; ich<24; ich++){
+      for(Int_t ich=0; ich<nTZEROChannels; ich++){
         weight=esdT0->GetT0amplitude()[ich];
         if(weight > fTZEROSignalThreshold) {
           fAliQnCorrectionsManager->AddDataVector(kTZERO, phi[ich], weight, ich);   // 1st ich is position in array, 2nd ich is channel id
@@ -442,9 +748,9 @@ void AliQnCorrectionsFillEventTask::FillTZERO(){
     }
   }
   else {
-    const AliAODTZERO* aodT0 = dynamic_cast<AliAODEvent*>(fEvent)->GetTZEROData();
+    const AliAODTZERO* aodT0 = fAODEvent->GetTZEROData();
     if (aodT0 != NULL) {
-      for(Int_t ich=0; ich<24; ich++){
+      for(Int_t ich=0; ich<nTZEROChannels; ich++){
         weight=aodT0->GetAmp(ich);
         if(weight > fTZEROSignalThreshold) {
           fAliQnCorrectionsManager->AddDataVector(kTZERO, phi[ich], weight, ich);   // 1st ich is position in array, 2nd ich is channel id
@@ -468,27 +774,18 @@ void AliQnCorrectionsFillEventTask::FillZDC(){
 
 
   Double_t weight=0.0;
-  const Double_t kX[10] = { /* Cside */ 0.0,  -1.75,  1.75, -1.75, 1.75,
-                            /* Aside */  0.0,  1.75, -1.75, 1.75, -1.75  };
-  const Double_t kY[10] = { /* Cside */ 0.0,  -1.75, -1.75,  1.75, 1.75,
-                            /* Aside */  0.0, -1.75, -1.75, 1.75,  1.75  };
-  const Double_t phi[10] = {0.0, TMath::ATan2(kY[1],kX[1]), TMath::ATan2(kY[2],kX[2]),
-      TMath::ATan2(kY[3],kX[3]), TMath::ATan2(kY[4],kX[4]), 0.0,
-      TMath::ATan2(kY[6],kX[6]), TMath::ATan2(kY[7],kX[7]),
-      TMath::ATan2(kY[8],kX[8]), TMath::ATan2(kY[9],kX[9]) };
-
 
   AliVZDC* zdc = (AliVZDC*) fEvent->GetZDCData();
 
-  Double_t ZDCenergy[10];
+  Double_t ZDCenergy[nZDCChannels];
   for(Int_t i=0; i<5; ++i)    ZDCenergy[i]  = zdc->GetZNCTowerEnergy()[i];
   for(Int_t i=5; i<10; ++i)   ZDCenergy[i]  = zdc->GetZNATowerEnergy()[i-5];
 
-  for(Int_t ich=1; ich<10; ich++){
-    if(ich==5) continue;
+  for(Int_t tower=0; tower<nZDCTowers; tower++){
+    Int_t ich = channelTables.fZDCTowerId[tower];
     weight=ZDCenergy[ich];
     if(weight > fZDCSignalThreshold) {
-      fAliQnCorrectionsManager->AddDataVector(kZDC, phi[ich], weight, ich);   // 1st ich is position in array, 2nd ich is channel id
+      fAliQnCorrectionsManager->AddDataVector(kZDC, channelTables.fZDCPhi[ich], weight, ich);   // 1st ich is position in array, 2nd ich is channel id
     }
   }
 }
@@ -500,111 +797,164 @@ void AliQnCorrectionsFillEventTask::FillFMD()
   // fill ESD FMD info
   //
 
-  Float_t m,phi;
+  if (fForwardMult == NULL) {
+    AliAODEvent* aodEvent = AliForwardUtil::GetAODEvent(this);
 
-  AliAODEvent* aodEvent = AliForwardUtil::GetAODEvent(this);
 
+    if (!aodEvent) {
+      AliFatal("Didn't get AOD event. Aborting! Check the AOD event handler presence.\n");
+      return;
+    }
 
-  if (!aodEvent) {
-    AliFatal("Didn't get AOD event. Aborting! Check the AOD event handler presence.\n");
-    return;
-  }
 
+    TObject* obj = aodEvent->FindListObject("Forward");
+    if (!obj) {
+      AliError("Didn't get the AOD Forward multiplicity object instance\n");
+      return;
+    }
 
-  TObject* obj = aodEvent->FindListObject("Forward");
-  if (!obj) {
-    AliError("Didn't get the AOD Forward multiplicity object instance\n");
-    return;
+    fForwardMult = static_cast<AliAODForwardMult*>(obj);
   }
 
-  AliAODForwardMult* aodForward = static_cast<AliAODForwardMult*>(obj);
-
-  const TH2D& d2Ndetadphi = aodForward->GetHistogram();
+  const TH2D& d2Ndetadphi = fForwardMult->GetHistogram();
 
   Int_t nEta = d2Ndetadphi.GetXaxis()->GetNbins();
   Int_t nPhi = d2Ndetadphi.GetYaxis()->GetNbins();
 
+  /* the phi bins center only change if the binning does */
+  if ((nEta != fFMDNoOfEtaBins) || (nPhi != fFMDNoOfPhiBins)) {
+    delete [] fFMDPhiBinCenter;
+    delete [] fFMDSelectedBins;
+    fFMDPhiBinCenter = new Float_t[nPhi + 1];
+    fFMDSelectedBins = new Int_t[nEta * nPhi];
+    for (Int_t iPhi = 1; iPhi <= nPhi; iPhi++)
+      fFMDPhiBinCenter[iPhi] = d2Ndetadphi.GetYaxis()->GetBinCenter(iPhi);
+    fFMDNoOfEtaBins = nEta;
+    fFMDNoOfPhiBins = nPhi;
+  }
+
+  /* the bins storage: bin (iEta, iPhi) is at iEta + (nEta + 2) * iPhi */
+  const Double_t *bins = d2Ndetadphi.GetArray();
+  const Int_t phiStride = nEta + 2;
 
   // Loop over eta 
-  Int_t nFMD=-1;
+  Int_t nSelected = 0;
   for (Int_t iEta = 1; iEta <= nEta; iEta++) {
-    Int_t valid = Int_t(d2Ndetadphi.GetBinContent(iEta, 0));
+    Int_t valid = Int_t(bins[iEta]);   /* the eta row underflow phi bin */
     if (!valid) continue; // No data expected for this eta 
 
     // Loop over phi 
     for (Int_t iPhi = 1; iPhi <= nPhi; iPhi++) {
-      phi = d2Ndetadphi.GetYaxis()->GetBinCenter(iPhi);
-      m     =  d2Ndetadphi.GetBinContent(iEta, iPhi);
-      if(m > fFMDSignalThreshold) {
-        nFMD++;
-        fAliQnCorrectionsManager->AddDataVector(kFMD, phi, m, iEta*nPhi+iPhi);   // 1st ich is position in array, 2nd ich is channel id
-      }
+      Int_t bin = iEta + phiStride * iPhi;
+      fFMDSelectedBins[nSelected] = bin;
+      nSelected += (Float_t(bins[bin]) > fFMDSignalThreshold);
     }
   }
+
+  /* and now the selected cells to the framework */
+  for (Int_t i = 0; i < nSelected; i++) {
+    Int_t bin = fFMDSelectedBins[i];
+    Int_t iEta = bin % phiStride;
+    Int_t iPhi = bin / phiStride;
+    Float_t m = bins[bin];
+    fAliQnCorrectionsManager->AddDataVector(kFMD, fFMDPhiBinCenter[iPhi], m, iEta*nPhi+iPhi);   // 1st ich is position in array, 2nd ich is channel id
+  }
 }
 
 
 
+//_________________________________
+/// The raw FMD layout as seen from the ESD FMD object
+static const Int_t nRawFMDNoOfDetectors       = 3;           ///< the number of FMD detectors
+static const UShort_t rawFMDDetectorNumber[]  = {1,2,3};     ///< the number of the FMD detector
+static const Int_t rawFMDNoOfRings[]          = {1,2,2};     ///< the number of rings for each detector
+static const Char_t rawFMDRingId[]            = {'I','O'};   ///< ring identity
+static const Int_t rawFMDRingNoOfSectors[]    = {20,40};     ///< ring number of sectors
+static const Int_t rawFMDRingNoOfStrips[]     = {512,256};   ///< ring number of strips per sector
+
+/// Builds the raw FMD strip geometry table
+///
+/// The azimuthal angle and the global sector id of each raw FMD
+/// strip are stored flat in strip order, i.e. in the same order
+/// the strips are visited by FillRawFMD. The geometry does not change
+/// within a run so the table is built once per run from NotifyRun
+/// instead of being queried to the ESD FMD object on each event.
+void AliQnCorrectionsFillEventTask::BuildRawFMDStripGeometry()
+{
+  fRawFMDStripGeometryBuilt = kFALSE;
+
+  if (!fFillRawFMD) return;
+
+  AliVEvent *event = InputEvent();
+  if (event == NULL || event->IsA() != AliESDEvent::Class()) return;
+
+  AliESDFMD* esdFmd = static_cast<AliESDEvent*>(event)->GetFMDData();
+  if (esdFmd == NULL) {
+    AliError("AliESDFMD not available. The raw FMD strip geometry could not be built");
+    return;
+  }
+
+  if (fRawFMDStripPhi == NULL) {
+    fRawFMDStripPhi = new Double_t[fRawFMDNoOfStrips];
+    fRawFMDStripSectorId = new Short_t[fRawFMDNoOfStrips];
+    fRawFMDRingStripEta = new Float_t[fRawFMDMaxStripsPerSector];
+  }
+
+  Int_t nStripId = 0;
+  Int_t nSectorId = 0;
+  for(Int_t detector = 0; detector < nRawFMDNoOfDetectors; detector++) {
+    for(Int_t ring = 0; ring < rawFMDNoOfRings[detector]; ring++) {
+      for(Int_t sector = 0; sector < rawFMDRingNoOfSectors[ring]; sector++) {
+        Double_t phi = esdFmd->Phi(rawFMDDetectorNumber[detector], rawFMDRingId[ring], sector, 0) / 180. * TMath::Pi();
+        for(Int_t strip = 0; strip < rawFMDRingNoOfStrips[ring]; strip++) {
+          fRawFMDStripPhi[nStripId] = phi;
+          fRawFMDStripSectorId[nStripId] = nSectorId;
+          nStripId++;
+        }
+        nSectorId++;
+      }
+    }
+  }
+  fRawFMDStripGeometryBuilt = kTRUE;
+}
+
 //_________________________________
 void AliQnCorrectionsFillEventTask::FillRawFMD()
 {
   //
   // fill Raw FMD info
   //
-  Bool_t isESD = (fEvent->IsA()==AliESDEvent::Class());
-  if(!isESD) return;
-
-  AliESDEvent* esdEvent = static_cast<AliESDEvent*>(fEvent);
-
-  AliESDFMD* esdFmd = esdEvent->GetFMDData();
-/*
-  Int_t id=-1;
-  Int_t maxDet=3;
-  Int_t maxRing=2;
-  Int_t maxSector;
-  Int_t maxStrip;
-  Float_t m=0.0;
-  Double_t phi,eta;
-  Char_t ring;
-*/
-  Int_t nNoOfDetectors       = 3;           ///< the number of FMD detectors
-  Int_t detectorNumber[]     = {1,2,3};     ///< the number of the FMD detector
-  Int_t nNoOfRings[]         = {1,2,2};     ///< the number of rings for each detector
-  Char_t ringId[]            = {'I','O'};   ///< ring identity
-  Int_t ringNoOfSectors[]    = {20,40};   ///< ring number of sectors
-  Int_t ringNoOfStrips[]     = {512,256};     ///< ring number of strips per sector
-  Int_t nSectorId = 0;
+  if(!fIsESD) return;
 
+  if (!fRawFMDStripGeometryBuilt) {
+    BuildRawFMDStripGeometry();
+    if (!fRawFMDStripGeometryBuilt) return;
+  }
 
-  /**
-   * Get the azimuthal angle of
-   * @f$ \text{FMD}\langle detector\rangle\lange ring\rangle_{\langle
-   * sector\rangle\langle strip\rangle}@f$
-   *
-   * @param detector Detector number (1-3)
-   * @param ring     Ring identifier ('I' or 'O')
-   * @param sector   Sector number (0-19, or 0-39)
-   * @param strip    Strip number (0-511, or 0-255)
-   *
-   * @return Azimuthal angle
-   */
-
-  for(Int_t detector = 0; detector < nNoOfDetectors; detector++) {
-    for(Int_t ring = 0; ring < nNoOfRings[detector]; ring++) {
-      for(Int_t sector = 0; sector < ringNoOfSectors[ring]; sector++) {
-        Double_t phi  =  esdFmd->Phi(detectorNumber[detector], ringId[ring], sector, 0) / 180. * TMath::Pi();
-        for(Int_t strip = 0; strip < ringNoOfStrips[ring]; strip++) {
-          Double_t eta  =  esdFmd->Eta(detectorNumber[detector], ringId[ring], sector, strip);
-          Float_t m = esdFmd->Multiplicity(detectorNumber[detector], ringId[ring], sector, strip);
+  AliESDFMD* esdFmd = fESDEvent->GetFMDData();
+
+  /* the strip geometry comes from the per run table. The multiplicities and the
+   * pseudorapidities, which depend on the event vertex, are still taken from the
+   * ESD FMD object but the pseudorapidity does not depend on the sector so it is
+   * only queried once per ring strip */
+  Int_t nStripId = 0;
+  for(Int_t detector = 0; detector < nRawFMDNoOfDetectors; detector++) {
+    UShort_t detectorNumber = rawFMDDetectorNumber[detector];
+    for(Int_t ring = 0; ring < rawFMDNoOfRings[detector]; ring++) {
+      Char_t ringId = rawFMDRingId[ring];
+      Int_t nNoOfStrips = rawFMDRingNoOfStrips[ring];
+      for(Int_t strip = 0; strip < nNoOfStrips; strip++) {
+        fRawFMDRingStripEta[strip] = esdFmd->Eta(detectorNumber, ringId, 0, strip);
+      }
+      for(Int_t sector = 0; sector < rawFMDRingNoOfSectors[ring]; sector++) {
+        for(Int_t strip = 0; strip < nNoOfStrips; strip++, nStripId++) {
+          Float_t m = esdFmd->Multiplicity(detectorNumber, ringId, sector, strip);
           if(m !=  AliESDFMD::kInvalidMult) {
-            fDataBank[kFMDEta] = eta;
-            fAliQnCorrectionsManager->AddDataVector(kFMDraw, phi, m, nSectorId);   // 1st ich is position in array, 2nd ich is channel id
+            fDataBank[kFMDEta] = fRawFMDRingStripEta[strip];
+            fAliQnCorrectionsManager->AddDataVector(kFMDraw, fRawFMDStripPhi[nStripId], m, fRawFMDStripSectorId[nStripId]);   // 1st ich is position in array, 2nd ich is channel id
           }
         }  // end loop over strips
-        nSectorId++;
-      }  // end loop over sectors      
+      }  // end loop over sectors
     }  // end loop over rings
   } // end loop over detectors
 }
-
-
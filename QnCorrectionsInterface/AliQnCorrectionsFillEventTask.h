@@ -16,6 +16,7 @@
 #include <AliAnalysisTaskSE.h>
 #include <AliInputEventHandler.h>
 #include <AliESDInputHandler.h>
+#include <TArrayI.h>
 
 #include "AliQnCorrectionsManager.h"
 #include "AliQnCorrectionsVarManagerTask.h"
@@ -23,9 +24,21 @@
 
 class AliESDtrack;
 class AliVParticle;
+class AliAODEvent;
+class TClonesArray;
+class AliAODForwardMult;
+class TObjArray;
+class AliQnCorrectionsCutsSet;
 
 class AliQnCorrectionsFillEventTask : public AliQnCorrectionsVarManagerTask {
 public:
+  /// \enum InputEventFormat
+  /// \brief The supported input event formats
+  enum InputEventFormat {
+    INPUTFMT_unknown,  ///< the input event format is not known yet
+    INPUTFMT_ESD,      ///< ESD input events
+    INPUTFMT_AOD       ///< AOD input events
+  };
 
   AliQnCorrectionsFillEventTask();
   AliQnCorrectionsFillEventTask(const char *name);
@@ -36,13 +49,21 @@ public:
   virtual void UserExec(Option_t *) = 0;
   virtual void UserCreateOutputObjects() = 0;
   virtual void FinishTaskOutput() = 0;
+  virtual Bool_t Notify();
 
 
   void SetUseTPCStandaloneTracks(Bool_t enable = kTRUE) { fUseTPCStandaloneTracks = enable; }
   void SetUseOnlyCentCalibEvents(Bool_t enable = kTRUE) { fUseOnlyCentCalibEvents = enable; }
+  void SetDemandDrivenTrackVariables(Bool_t enable = kTRUE) { fDemandDrivenTrackVariables = enable; }
+  void AddTrackVariablesUsedByCuts(const AliQnCorrectionsCutsSet *cuts);
+  void SetRunsList(const TObjArray *runsList);
+  /// Gets the number of runs in the configured runs list
+  /// \return the number of bins of the run indexed axes
+  Int_t GetNoOfRuns() const { return fSortedRunNumbers.GetSize(); }
 
 protected:
   /* Fill event data methods */
+  void ResolveInputEventFormat();
   void FillEventData();
 
   void FillDetectors();
@@ -56,11 +77,23 @@ protected:
   void FillRawFMD();
   void FillSPDTracklets();
 
+  void BuildTrackVariablesMask();
+  void ResetUnextractedTrackVariables();
+
+  /* FMD cached access */
+  void InvalidateFMDCache() { fForwardMult = NULL; fFMDNoOfEtaBins = 0; fFMDNoOfPhiBins = 0; }
+
+  /* per event arena */
+  void ResetEventArena() { fNoOfTPCOnlyTracksInArena = 0; }
+  AliESDtrack *GetTPCOnlyTrackFromArena(AliESDtrack *esdTrack);
+
   void FillEventInfo();
+  Int_t GetRunIndex(Int_t runNumber);
   void FillTrackInfo(AliESDtrack* p);
   void FillTrackInfo(AliVParticle* p);
 
   void SetDetectors();
+  void BuildRawFMDStripGeometry();
 
 private:
 
@@ -72,14 +105,21 @@ protected:
   AliQnCorrectionsManager *fAliQnCorrectionsManager;
   AliQnCorrectionsHistos* fEventHistos;
   Float_t *fDataBank;                             //!<! The event variables values data bank. Transient!
+  Bool_t fFillTrackQA;                            //!<! the track QA histogram classes are filled for the current event. Transient!
 private:
   static const Float_t fVZEROSignalThreshold; ///< the VZERO channel signal threshold for building a data vector
   static const Float_t fTZEROSignalThreshold; ///< the TZERO channel signal threshold for building a data vector
   static const Float_t fZDCSignalThreshold; ///< the ZDC channel signal threshold for building a data vector
   static const Float_t fFMDSignalThreshold; ///< the FMD channel signal threshold for building a data vector
+  static const Int_t fRawFMDNoOfStrips = 51200; ///< the number of raw FMD strips: 3 x 20 x 512 inner plus 2 x 40 x 256 outer
+  static const Int_t fRawFMDMaxStripsPerSector = 512; ///< the maximum number of strips in a raw FMD sector
 
   Bool_t fUseOnlyCentCalibEvents;
   Bool_t fUseTPCStandaloneTracks;
+  Bool_t fDemandDrivenTrackVariables;             ///< extract only the track variables used by cuts and histograms
+  TString fTrackVariablesUsedByCuts;              ///< the variables used by the registered detector configurations cuts
+  TArrayI fSortedRunNumbers;                      ///< the configured runs list run numbers, sorted for the run index search
+  TArrayI fSortedRunIndices;                      ///< the position in the configured runs list of each sorted run number
   Bool_t fFillVZERO;
   Bool_t fFillTPC;
   Bool_t fFillZDC;
@@ -89,8 +129,31 @@ private:
   Bool_t fFillSPD;
   Bool_t fIsAOD;
   Bool_t fIsESD;
-
-  ClassDef(AliQnCorrectionsFillEventTask, 2);
+  InputEventFormat fInputEventFormat;             //!<! the input event format, resolved once. Transient!
+  AliESDEvent *fESDEvent;                         //!<! the current event if ESD, NULL otherwise. Transient!
+  AliAODEvent *fAODEvent;                         //!<! the current event if AOD, NULL otherwise. Transient!
+  Int_t fRunIndexRunNumber;                       //!<! the run number the current run index was resolved for. Transient!
+  Int_t fRunIndex;                                //!<! the current run index within the configured runs list. Transient!
+
+  Bool_t fRawFMDStripGeometryBuilt;               //!<! the raw FMD strip geometry table is available. Transient!
+  Double_t *fRawFMDStripPhi;                      //!<! azimuthal angle of each raw FMD strip in strip order. Transient!
+  Short_t *fRawFMDStripSectorId;                  //!<! global sector id of each raw FMD strip in strip order. Transient!
+  Float_t *fRawFMDRingStripEta;                   //!<! the current event strip pseudorapidities for the ring being filled. Transient!
+
+  Bool_t fTrackVariablesMask[kNVars];             //!<! the track variables to extract. Transient!
+  Int_t fNoOfUnextractedTrackVariables;          //!<! the number of track variables not extracted. Transient!
+  Int_t fUnextractedTrackVariables[kNVars];       //!<! the track variables not extracted, set to NaN for each event. Transient!
+
+  AliAODForwardMult *fForwardMult;                //!<! the cached AOD forward multiplicity object for the current input. Transient!
+  Int_t fFMDNoOfEtaBins;                          //!<! the cached forward d2N/detadphi number of eta bins. Transient!
+  Int_t fFMDNoOfPhiBins;                          //!<! the cached forward d2N/detadphi number of phi bins. Transient!
+  Float_t *fFMDPhiBinCenter;                      //!<! the cached forward d2N/detadphi phi bins center. Transient!
+  Int_t *fFMDSelectedBins;                        //!<! the forward d2N/detadphi bins above threshold in the current event. Transient!
+
+  TClonesArray *fTPCOnlyTracksArena;              //!<! the per event TPC only tracks storage, reused event by event. Transient!
+  Int_t fNoOfTPCOnlyTracksInArena;                //!<! the number of TPC only tracks handed out in the current event. Transient!
+
+  ClassDef(AliQnCorrectionsFillEventTask, 9);
 };
 
 #endif
@@ -0,0 +1,53 @@
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+#include <TSystem.h>
+#include "AliLog.h"
+
+#include "AliQnCorrectionsLocalCalibrationFetcher.h"
+
+ClassImp(AliQnCorrectionsLocalCalibrationFetcher)
+
+/// Default constructor
+AliQnCorrectionsLocalCalibrationFetcher::AliQnCorrectionsLocalCalibrationFetcher() :
+    AliQnCorrectionsCalibrationFetcher(),
+    fDirectory("")
+{
+}
+
+/// Normal constructor
+/// \param directory the directory the calibration files are taken from
+AliQnCorrectionsLocalCalibrationFetcher::AliQnCorrectionsLocalCalibrationFetcher(const char *directory) :
+    AliQnCorrectionsCalibrationFetcher(),
+    fDirectory(directory)
+{
+}
+
+/// Default destructor
+AliQnCorrectionsLocalCalibrationFetcher::~AliQnCorrectionsLocalCalibrationFetcher() {
+}
+
+/// Copies the local directory file with the source file name to a local file
+/// \param source the calibration file source name
+/// \param destination the local file name
+/// \param sourceSize the size of the local directory file, in bytes
+/// \return kTRUE if the copy succeeded
+Bool_t AliQnCorrectionsLocalCalibrationFetcher::Fetch(const char *source, const char *destination, Long64_t &sourceSize) {
+
+  TString localFile = Form("%s/%s", fDirectory.Data(), gSystem->BaseName(source));
+
+  sourceSize = -1;
+  FileStat_t stat;
+  if (gSystem->GetPathInfo(localFile, stat) != 0) {
+    AliWarning(Form("Calibration file %s not found in %s", gSystem->BaseName(source), fDirectory.Data()));
+    return kFALSE;
+  }
+  sourceSize = stat.fSize;
+  return (gSystem->CopyFile(localFile, destination, kTRUE) == 0);
+}
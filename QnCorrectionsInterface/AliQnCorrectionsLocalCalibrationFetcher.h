@@ -0,0 +1,41 @@
+#ifndef ALIQNCORRECTIONS_LOCALCALIBRATIONFETCHER_H
+#define ALIQNCORRECTIONS_LOCALCALIBRATIONFETCHER_H
+
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+/// \file AliQnCorrectionsLocalCalibrationFetcher.h
+/// \brief Local directory fetch backend of the calibration files cache
+///
+/// Takes the calibration files from a local directory instead of from
+/// their source. Only the file name of the source is kept, so a directory
+/// with a copy of the grid or OADB per run calibration files stands for
+/// them in local tests of the calibration files cache.
+
+#include <TString.h>
+#include "AliQnCorrectionsCalibrationFetcher.h"
+
+class AliQnCorrectionsLocalCalibrationFetcher : public AliQnCorrectionsCalibrationFetcher {
+public:
+  AliQnCorrectionsLocalCalibrationFetcher();
+  AliQnCorrectionsLocalCalibrationFetcher(const char *directory);
+  virtual ~AliQnCorrectionsLocalCalibrationFetcher();
+
+  virtual Bool_t Fetch(const char *source, const char *destination, Long64_t &sourceSize);
+
+private:
+  TString fDirectory;                    ///< the directory the calibration files are taken from
+
+  AliQnCorrectionsLocalCalibrationFetcher(const AliQnCorrectionsLocalCalibrationFetcher &c);
+  AliQnCorrectionsLocalCalibrationFetcher& operator= (const AliQnCorrectionsLocalCalibrationFetcher &c);
+
+  ClassDef(AliQnCorrectionsLocalCalibrationFetcher, 1);
+};
+
+#endif // ALIQNCORRECTIONS_LOCALCALIBRATIONFETCHER_H
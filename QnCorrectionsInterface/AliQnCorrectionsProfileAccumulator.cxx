@@ -0,0 +1,210 @@
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+#include <string.h>
+
+#include <TH1.h>
+#include <TProfile.h>
+#include <TProfile2D.h>
+#include <TArrayD.h>
+#include "AliLog.h"
+
+#include "AliQnCorrectionsProfileAccumulator.h"
+
+ClassImp(AliQnCorrectionsProfileAccumulator)
+
+/// Default constructor
+AliQnCorrectionsProfileAccumulator::AliQnCorrectionsProfileAccumulator() :
+    TObject(),
+    fAxis(),
+    fNoOfCombinations(0),
+    fNoOfValues(0),
+    fNoOfCells(0),
+    fSumY(NULL),
+    fSumY2(NULL),
+    fBinEntries(NULL),
+    fEntries(NULL),
+    fTsumw(NULL),
+    fTsumwx(NULL),
+    fTsumwx2(NULL),
+    fTsumwy(NULL),
+    fTsumwy2(NULL)
+{
+}
+
+/// Normal constructor
+/// \param nCombinations the number of combinations
+/// \param nValues the number of values filled together for each combination
+/// \param nBins the number of abscissa bins
+/// \param binEdges the abscissa bins edges, nBins + 1 entries
+AliQnCorrectionsProfileAccumulator::AliQnCorrectionsProfileAccumulator(Int_t nCombinations, Int_t nValues, Int_t nBins, const Double_t *binEdges) :
+    TObject(),
+    fAxis(nBins, binEdges),
+    fNoOfCombinations(nCombinations),
+    fNoOfValues(nValues),
+    fNoOfCells(nBins + 2),
+    fSumY(NULL),
+    fSumY2(NULL),
+    fBinEntries(NULL),
+    fEntries(NULL),
+    fTsumw(NULL),
+    fTsumwx(NULL),
+    fTsumwx2(NULL),
+    fTsumwy(NULL),
+    fTsumwy2(NULL)
+{
+  Int_t nBinValues = fNoOfCombinations * fNoOfCells * fNoOfValues;
+  fSumY = new Double_t[nBinValues];
+  fSumY2 = new Double_t[nBinValues];
+  fBinEntries = new Double_t[fNoOfCombinations * fNoOfCells];
+  fEntries = new Double_t[fNoOfCombinations];
+  fTsumw = new Double_t[fNoOfCombinations];
+  fTsumwx = new Double_t[fNoOfCombinations];
+  fTsumwx2 = new Double_t[fNoOfCombinations];
+  fTsumwy = new Double_t[fNoOfCombinations * fNoOfValues];
+  fTsumwy2 = new Double_t[fNoOfCombinations * fNoOfValues];
+
+  memset(fSumY, 0, nBinValues * sizeof(Double_t));
+  memset(fSumY2, 0, nBinValues * sizeof(Double_t));
+  memset(fBinEntries, 0, fNoOfCombinations * fNoOfCells * sizeof(Double_t));
+  memset(fEntries, 0, fNoOfCombinations * sizeof(Double_t));
+  memset(fTsumw, 0, fNoOfCombinations * sizeof(Double_t));
+  memset(fTsumwx, 0, fNoOfCombinations * sizeof(Double_t));
+  memset(fTsumwx2, 0, fNoOfCombinations * sizeof(Double_t));
+  memset(fTsumwy, 0, fNoOfCombinations * fNoOfValues * sizeof(Double_t));
+  memset(fTsumwy2, 0, fNoOfCombinations * fNoOfValues * sizeof(Double_t));
+}
+
+/// Default destructor
+AliQnCorrectionsProfileAccumulator::~AliQnCorrectionsProfileAccumulator() {
+  delete [] fSumY;
+  delete [] fSumY2;
+  delete [] fBinEntries;
+  delete [] fEntries;
+  delete [] fTsumw;
+  delete [] fTsumwx;
+  delete [] fTsumwx2;
+  delete [] fTsumwy;
+  delete [] fTsumwy2;
+}
+
+/// Fills the values of a combination for an abscissa bin
+/// \param combination the combination
+/// \param bin the abscissa bin as returned by FindBin
+/// \param x the abscissa
+/// \param values the values, one per value slot of the combination
+void AliQnCorrectionsProfileAccumulator::Fill(Int_t combination, Int_t bin, Double_t x, const Double_t *values) {
+
+  Double_t *sumY = fSumY + (combination * fNoOfCells + bin) * fNoOfValues;
+  Double_t *sumY2 = fSumY2 + (combination * fNoOfCells + bin) * fNoOfValues;
+  for (Int_t i = 0; i < fNoOfValues; i++) {
+    sumY[i] += values[i];
+    sumY2[i] += values[i] * values[i];
+  }
+  fBinEntries[combination * fNoOfCells + bin] += 1;
+  fEntries[combination] += 1;
+
+  /* as TProfile does, only in range entries go to the statistics */
+  if ((bin == 0 || bin > fAxis.GetNbins()) && !TH1::GetStatOverflows()) return;
+
+  fTsumw[combination] += 1;
+  fTsumwx[combination] += x;
+  fTsumwx2[combination] += x * x;
+  Double_t *tsumwy = fTsumwy + combination * fNoOfValues;
+  Double_t *tsumwy2 = fTsumwy2 + combination * fNoOfValues;
+  for (Int_t i = 0; i < fNoOfValues; i++) {
+    tsumwy[i] += values[i];
+    tsumwy2[i] += values[i] * values[i];
+  }
+}
+
+/// Stores the accumulated content of a value of a combination into a profile
+///
+/// The profile is expected empty and with the same binning than the accumulator.
+/// \param combination the combination
+/// \param value the value slot within the combination
+/// \param profile the profile to store the content into
+void AliQnCorrectionsProfileAccumulator::Materialise(Int_t combination, Int_t value, TProfile *profile) const {
+
+  if (profile->GetNbinsX() + 2 != fNoOfCells) {
+    AliError(Form("Profile %s binning does not match the accumulator one", profile->GetName()));
+    return;
+  }
+
+  Double_t *contents = profile->GetArray();
+  TArrayD *sumw2 = profile->GetSumw2();
+  TArrayD *binSumw2 = profile->GetBinSumw2();
+  for (Int_t bin = 0; bin < fNoOfCells; bin++) {
+    Int_t cell = (combination * fNoOfCells + bin) * fNoOfValues + value;
+    contents[bin] = fSumY[cell];
+    if (sumw2->GetSize() != 0) sumw2->GetArray()[bin] = fSumY2[cell];
+    profile->SetBinEntries(bin, fBinEntries[combination * fNoOfCells + bin]);
+    if (binSumw2->GetSize() != 0) binSumw2->GetArray()[bin] = fBinEntries[combination * fNoOfCells + bin];
+  }
+  profile->SetEntries(fEntries[combination]);
+
+  Double_t stats[6];
+  stats[0] = fTsumw[combination];
+  stats[1] = fTsumw[combination];
+  stats[2] = fTsumwx[combination];
+  stats[3] = fTsumwx2[combination];
+  stats[4] = fTsumwy[combination * fNoOfValues + value];
+  stats[5] = fTsumwy2[combination * fNoOfValues + value];
+  profile->PutStats(stats);
+}
+
+/// Stores the accumulated content of a value of a combination into a row of a 2D profile
+///
+/// The profile is expected with the same X binning than the accumulator and the row
+/// empty. The content and the statistics are added to the ones already in the profile,
+/// as if the values had been filled with the Y coordinate of the row center. Several
+/// combinations can in this way share a 2D profile, one per row.
+/// \param combination the combination
+/// \param value the value slot within the combination
+/// \param profile the 2D profile to store the content into
+/// \param ybin the profile row
+void AliQnCorrectionsProfileAccumulator::MaterialiseRow(Int_t combination, Int_t value, TProfile2D *profile, Int_t ybin) const {
+
+  if (profile->GetNbinsX() + 2 != fNoOfCells || ybin < 0 || ybin > profile->GetNbinsY() + 1) {
+    AliError(Form("Profile %s binning does not match the accumulator one", profile->GetName()));
+    return;
+  }
+
+  Double_t *contents = profile->GetArray();
+  TArrayD *sumw2 = profile->GetSumw2();
+  TArrayD *binSumw2 = profile->GetBinSumw2();
+  for (Int_t bin = 0; bin < fNoOfCells; bin++) {
+    Int_t cell = (combination * fNoOfCells + bin) * fNoOfValues + value;
+    Int_t globalBin = profile->GetBin(bin, ybin);
+    contents[globalBin] = fSumY[cell];
+    if (sumw2->GetSize() != 0) sumw2->GetArray()[globalBin] = fSumY2[cell];
+    profile->SetBinEntries(globalBin, fBinEntries[combination * fNoOfCells + bin]);
+    if (binSumw2->GetSize() != 0) binSumw2->GetArray()[globalBin] = fBinEntries[combination * fNoOfCells + bin];
+  }
+
+  /* the rows out of the Y range do not contribute to the statistics */
+  /* the entries are updated afterwards so that the stored statistics are taken */
+  Double_t entries = profile->GetEntries();
+  if (!(ybin == 0 || ybin > profile->GetNbinsY()) || TH1::GetStatOverflows()) {
+    Double_t y = profile->GetYaxis()->GetBinCenter(ybin);
+    Double_t stats[9];
+    profile->GetStats(stats);
+    stats[0] += fTsumw[combination];
+    stats[1] += fTsumw[combination];
+    stats[2] += fTsumwx[combination];
+    stats[3] += fTsumwx2[combination];
+    stats[4] += fTsumw[combination] * y;
+    stats[5] += fTsumw[combination] * y * y;
+    stats[6] += fTsumwx[combination] * y;
+    stats[7] += fTsumwy[combination * fNoOfValues + value];
+    stats[8] += fTsumwy2[combination * fNoOfValues + value];
+    profile->PutStats(stats);
+  }
+  profile->SetEntries(entries + fEntries[combination]);
+}
@@ -0,0 +1,65 @@
+#ifndef ALIQNCORRECTIONS_PROFILEACCUMULATOR_H
+#define ALIQNCORRECTIONS_PROFILEACCUMULATOR_H
+
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+/// \file AliQnCorrectionsProfileAccumulator.h
+/// \brief Flat storage of a set of profiles sharing the same axis
+///
+/// The accumulator holds, for several combinations, a group of values which
+/// are filled together for the same abscissa. The abscissa bin is found once
+/// per event and the sums, sums of squares and entries of each value are kept
+/// in contiguous arrays laid out by (combination, bin, value), so the per value
+/// loop is a plain vectorizable loop. The bookkeeping mimics TProfile::Fill with
+/// unit weights, so that the profiles materialised at the end have the same
+/// content and statistics than if they had been filled event by event.
+
+#include <TObject.h>
+#include <TAxis.h>
+
+class TProfile;
+class TProfile2D;
+
+class AliQnCorrectionsProfileAccumulator : public TObject {
+public:
+  AliQnCorrectionsProfileAccumulator();
+  AliQnCorrectionsProfileAccumulator(Int_t nCombinations, Int_t nValues, Int_t nBins, const Double_t *binEdges);
+  virtual ~AliQnCorrectionsProfileAccumulator();
+
+  /// Gets the bin of an abscissa, as TAxis::FindBin does
+  /// \param x the abscissa
+  /// \return the bin number, 0 for underflow and number of bins + 1 for overflow
+  Int_t FindBin(Double_t x) const { return fAxis.FindFixBin(x); }
+  void Fill(Int_t combination, Int_t bin, Double_t x, const Double_t *values);
+  void Materialise(Int_t combination, Int_t value, TProfile *profile) const;
+  void MaterialiseRow(Int_t combination, Int_t value, TProfile2D *profile, Int_t ybin) const;
+
+private:
+  TAxis fAxis;                                     ///< the abscissa axis
+  Int_t fNoOfCombinations;                         ///< the number of combinations
+  Int_t fNoOfValues;                               ///< the number of values per combination
+  Int_t fNoOfCells;                                ///< the number of bins, underflow and overflow included
+  Double_t *fSumY;                                 //!<! the sum of values per combination, bin and value. Transient!
+  Double_t *fSumY2;                                //!<! the sum of squared values per combination, bin and value. Transient!
+  Double_t *fBinEntries;                           //!<! the entries per combination and bin. Transient!
+  Double_t *fEntries;                              //!<! the fills per combination. Transient!
+  Double_t *fTsumw;                                //!<! the in range fills per combination. Transient!
+  Double_t *fTsumwx;                               //!<! the in range sum of abscissas per combination. Transient!
+  Double_t *fTsumwx2;                              //!<! the in range sum of squared abscissas per combination. Transient!
+  Double_t *fTsumwy;                               //!<! the in range sum of values per combination and value. Transient!
+  Double_t *fTsumwy2;                              //!<! the in range sum of squared values per combination and value. Transient!
+
+  AliQnCorrectionsProfileAccumulator(const AliQnCorrectionsProfileAccumulator &c);
+  AliQnCorrectionsProfileAccumulator& operator= (const AliQnCorrectionsProfileAccumulator &c);
+
+  ClassDef(AliQnCorrectionsProfileAccumulator, 1);
+};
+
+#endif // ALIQNCORRECTIONS_PROFILEACCUMULATOR_H
@@ -0,0 +1,186 @@
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+#include <TList.h>
+#include <TNamed.h>
+#include <TFile.h>
+#include <TMemFile.h>
+#include <TKey.h>
+#include <TUrl.h>
+#include "AliLog.h"
+
+#include "AliQnCorrectionsRunIndexedCalibration.h"
+
+ClassImp(AliQnCorrectionsRunIndexedCalibration)
+
+const char *AliQnCorrectionsRunIndexedCalibration::fIndexKeyName = "QnCorrectionsRunIndex";
+
+/// Default constructor
+AliQnCorrectionsRunIndexedCalibration::AliQnCorrectionsRunIndexedCalibration() :
+    TObject(),
+    fFile(NULL),
+    fListName(""),
+    fNoOfRuns(0)
+{
+}
+
+/// Normal constructor
+/// \param file the open run indexed calibration file, the object takes ownership
+/// \param listName the name of the calibration histograms list
+AliQnCorrectionsRunIndexedCalibration::AliQnCorrectionsRunIndexedCalibration(TFile *file, const char *listName) :
+    TObject(),
+    fFile(file),
+    fListName(listName),
+    fNoOfRuns(file->GetNkeys() - 1)
+{
+}
+
+/// Default destructor
+AliQnCorrectionsRunIndexedCalibration::~AliQnCorrectionsRunIndexedCalibration() {
+  if (fFile != NULL) {
+    fFile->Close();
+    delete fFile;
+  }
+}
+
+/// Opens a run indexed calibration file
+///
+/// Only the file keys directory is read.
+/// \param fileName the calibration file name
+/// \return the run indexed calibration, NULL if the file is not there or it is not run indexed
+AliQnCorrectionsRunIndexedCalibration *AliQnCorrectionsRunIndexedCalibration::Open(const char *fileName) {
+
+  TFile *file = TFile::Open(fileName);
+  if (file == NULL || !file->IsOpen()) {
+    delete file;
+    return NULL;
+  }
+
+  TKey *indexKey = file->GetKey(fIndexKeyName);
+  if (indexKey == NULL) {
+    AliInfoClass(Form("Calibration file %s is not run indexed", fileName));
+    file->Close();
+    delete file;
+    return NULL;
+  }
+
+  TNamed *index = (TNamed *) indexKey->ReadObj();
+  AliQnCorrectionsRunIndexedCalibration *calibration =
+      new AliQnCorrectionsRunIndexedCalibration(file, index->GetTitle());
+  delete index;
+
+  AliInfoClass(Form("Run indexed calibration file %s open with %d runs", fileName, calibration->GetNoOfRuns()));
+  return calibration;
+}
+
+/// Gets the calibration file for a run
+///
+/// The run calibration histograms list is read and stored in a new in
+/// memory file. Nothing is kept here, the caller deletes the file once
+/// the calibration histograms are loaded.
+/// \param run the run number
+/// \return the run calibration file, owned by the caller. NULL if the run is not in the index
+TFile *AliQnCorrectionsRunIndexedCalibration::GetRunCalibrationFile(Int_t run) {
+
+  TKey *runKey = fFile->GetKey(Form("%d", run));
+  if (runKey == NULL) return NULL;
+
+  TList list;
+  list.SetName(fListName);
+  list.SetOwner(kTRUE);
+  list.Add(runKey->ReadObj());
+
+  TDirectory *current = gDirectory;
+  TFile *runFile = new TMemFile(Form("%s.%d", fFile->GetName(), run), "RECREATE");
+  runFile->cd();
+  list.Write(fListName, TObject::kSingleKey);
+  if (current != NULL) current->cd();
+  return runFile;
+}
+
+/// Gets where the calibration of a run is stored in the file
+///
+/// Only the keys directory, already in memory, is looked at.
+/// \param run the run number
+/// \param fileName on return, the local file name
+/// \param offset on return, the offset, in bytes, of the run key
+/// \param length on return, the length, in bytes, of the run key
+/// \return kTRUE if the file is a plain local one and the run is in the index
+Bool_t AliQnCorrectionsRunIndexedCalibration::GetRunByteRange(Int_t run, TString &fileName, Long64_t &offset, Long64_t &length) const {
+
+  if (fFile->IsA() != TFile::Class()) return kFALSE;
+
+  TKey *runKey = fFile->GetKey(Form("%d", run));
+  if (runKey == NULL) return kFALSE;
+
+  fileName = fFile->GetEndpointUrl()->GetFile();
+  offset = runKey->GetSeekKey();
+  length = runKey->GetNbytes();
+  return kTRUE;
+}
+
+/// Converts a calibration file to the run indexed layout
+///
+/// Each entry of the calibration histograms list is stored under its own
+/// key, the run lists under the run number, and the index key is added.
+/// \param inputFileName the calibration file name
+/// \param outputFileName the run indexed calibration file name
+/// \return kTRUE if the conversion succeeded
+Bool_t AliQnCorrectionsRunIndexedCalibration::CreateRunIndexedFile(const char *inputFileName, const char *outputFileName) {
+
+  TFile *inputFile = TFile::Open(inputFileName);
+  if (inputFile == NULL || !inputFile->IsOpen()) {
+    AliErrorClass(Form("Calibration file %s not available", inputFileName));
+    delete inputFile;
+    return kFALSE;
+  }
+
+  /* the calibration histograms list is the first key, as the framework takes it */
+  TKey *listKey = (inputFile->GetListOfKeys()->GetEntries() > 0) ? (TKey *) inputFile->GetListOfKeys()->At(0) : NULL;
+  TObject *obj = (listKey != NULL) ? listKey->ReadObj() : NULL;
+  if (obj == NULL || !obj->InheritsFrom(TList::Class())) {
+    AliErrorClass(Form("Calibration file %s does not contain a calibration histograms list", inputFileName));
+    delete obj;
+    inputFile->Close();
+    delete inputFile;
+    return kFALSE;
+  }
+  TList *list = (TList *) obj;
+  list->SetOwner(kTRUE);
+
+  TDirectory *current = gDirectory;
+  TFile *outputFile = TFile::Open(outputFileName, "RECREATE");
+  if (outputFile == NULL || !outputFile->IsOpen()) {
+    AliErrorClass(Form("Run indexed calibration file %s could not be created", outputFileName));
+    delete outputFile;
+    delete list;
+    inputFile->Close();
+    delete inputFile;
+    return kFALSE;
+  }
+
+  outputFile->cd();
+  TIter next(list);
+  TObject *entry;
+  while ((entry = next()) != NULL)
+    entry->Write(entry->GetName(), TObject::kSingleKey);
+  TNamed index(fIndexKeyName, listKey->GetName());
+  index.Write();
+
+  AliInfoClass(Form("Calibration file %s converted to run indexed file %s with %d entries",
+      inputFileName, outputFileName, list->GetEntries()));
+
+  outputFile->Close();
+  delete outputFile;
+  delete list;
+  inputFile->Close();
+  delete inputFile;
+  if (current != NULL) current->cd();
+  return kTRUE;
+}
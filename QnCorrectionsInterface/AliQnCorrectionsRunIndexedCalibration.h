@@ -0,0 +1,69 @@
+#ifndef ALIQNCORRECTIONS_RUNINDEXEDCALIBRATION_H
+#define ALIQNCORRECTIONS_RUNINDEXEDCALIBRATION_H
+
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+/// \file AliQnCorrectionsRunIndexedCalibration.h
+/// \brief Per run, on demand, access to a calibration file with every run
+///
+/// A calibration file, as produced by the framework, holds a single key with
+/// the calibration histograms list, which contains one list per run. Loading
+/// it means deserializing the calibration histograms of every run.
+///
+/// The run indexed layout stores each run list under its own key, named after
+/// the run, plus an index key which keeps the name of the original list. Opening
+/// such a file only reads its keys directory. The calibration of a run is then
+/// read on demand and handed out as an in memory file with the layout of the
+/// original one but only with the run list, so the framework takes it as it
+/// takes a full calibration file. The in memory file is owned by the caller,
+/// which deletes it once the framework has taken the calibration histograms,
+/// so only the framework copy of each loaded run stays in memory.
+///
+/// When the file is a plain local one, GetRunByteRange tells where the run
+/// calibration is stored, so that it can be read ahead without ROOT.
+///
+/// CreateRunIndexedFile converts a calibration file to the run indexed layout.
+
+#include <TObject.h>
+#include <TString.h>
+
+class TFile;
+
+class AliQnCorrectionsRunIndexedCalibration : public TObject {
+public:
+  AliQnCorrectionsRunIndexedCalibration();
+  virtual ~AliQnCorrectionsRunIndexedCalibration();
+
+  static AliQnCorrectionsRunIndexedCalibration *Open(const char *fileName);
+  static Bool_t CreateRunIndexedFile(const char *inputFileName, const char *outputFileName);
+
+  TFile *GetRunCalibrationFile(Int_t run);
+  Bool_t GetRunByteRange(Int_t run, TString &fileName, Long64_t &offset, Long64_t &length) const;
+
+  /// Gets the number of runs in the file index
+  /// \return the number of runs
+  Int_t GetNoOfRuns() const { return fNoOfRuns; }
+
+private:
+  AliQnCorrectionsRunIndexedCalibration(TFile *file, const char *listName);
+
+  static const char *fIndexKeyName;      ///< the name of the key identifying the run indexed layout
+
+  TFile *fFile;                          //!<! the run indexed calibration file. Transient!
+  TString fListName;                     //!<! the name of the calibration histograms list. Transient!
+  Int_t fNoOfRuns;                       //!<! the number of runs in the file index. Transient!
+
+  AliQnCorrectionsRunIndexedCalibration(const AliQnCorrectionsRunIndexedCalibration &c);
+  AliQnCorrectionsRunIndexedCalibration& operator= (const AliQnCorrectionsRunIndexedCalibration &c);
+
+  ClassDef(AliQnCorrectionsRunIndexedCalibration, 1);
+};
+
+#endif // ALIQNCORRECTIONS_RUNINDEXEDCALIBRATION_H
@@ -0,0 +1,199 @@
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+#include <TList.h>
+#include <TObjArray.h>
+#include <TClass.h>
+#include <THashList.h>
+#include <TFile.h>
+#include <TMemFile.h>
+#include <TKey.h>
+#include <TH1.h>
+#include <THn.h>
+#include <THnSparse.h>
+#include "AliLog.h"
+
+#include "AliQnCorrectionsSparseHistograms.h"
+
+ClassImp(AliQnCorrectionsSparseHistograms)
+
+/// Default constructor
+AliQnCorrectionsSparseHistograms::AliQnCorrectionsSparseHistograms() :
+    TObject()
+{
+}
+
+/// Default destructor
+AliQnCorrectionsSparseHistograms::~AliQnCorrectionsSparseHistograms() {
+}
+
+/// Creates a copy of a histograms list with the dense THn histograms stored as THnSparse
+///
+/// The list structure, names and the rest of objects are kept. Every dense
+/// histogram is stored as sparse, whatever its content, so that the copies
+/// made by different jobs have the same layout and merge.
+/// The passed list is not modified.
+/// \param list the histograms list
+/// \return the new list, owner of its content
+TList *AliQnCorrectionsSparseHistograms::CreateSparseCopy(const TList *list) {
+
+  Bool_t addStatus = TH1::AddDirectoryStatus();
+  TH1::AddDirectory(kFALSE);
+  TList *copy = CopyList(list);
+  TH1::AddDirectory(addStatus);
+  return copy;
+}
+
+/// Copies recursively a list storing the dense THn histograms as THnSparse
+/// \param list the list to copy
+/// \return the new list, owner of its content
+TList *AliQnCorrectionsSparseHistograms::CopyList(const TList *list) {
+
+  TList *copy = (list->InheritsFrom(THashList::Class())) ? new THashList() : new TList();
+  copy->SetName(list->GetName());
+  copy->SetOwner(kTRUE);
+
+  TIter next(list);
+  TObject *obj;
+  while ((obj = next()) != NULL) {
+    if (obj->InheritsFrom(TList::Class())) {
+      copy->Add(CopyList((const TList *) obj));
+      continue;
+    }
+    if (obj->InheritsFrom(THnBase::Class()) && !obj->InheritsFrom(THnSparse::Class())) {
+      const THnBase *dense = (const THnBase *) obj;
+      THnSparse *sparse = THnSparse::CreateSparse(dense->GetName(), dense->GetTitle(), dense);
+      if (sparse != NULL) {
+        copy->Add(sparse);
+        continue;
+      }
+      AliErrorClass(Form("Histogram %s could not be stored as sparse", dense->GetName()));
+    }
+    copy->Add(obj->Clone());
+  }
+  return copy;
+}
+
+/// Expands, in place, the THnSparse histograms of a list to dense THn ones
+///
+/// The dense histogram gets the name, the position in the list and the
+/// content type of the sparse one. Nested lists are expanded as well.
+/// \param list the histograms list
+/// \return the number of expanded histograms
+Int_t AliQnCorrectionsSparseHistograms::ExpandSparse(TList *list) {
+
+  Int_t nExpanded = 0;
+  for (Int_t i = 0; i < list->GetEntries(); i++) {
+    TObject *obj = list->At(i);
+    if (obj->InheritsFrom(TList::Class())) {
+      nExpanded += ExpandSparse((TList *) obj);
+      continue;
+    }
+    if (!obj->InheritsFrom(THnSparse::Class())) continue;
+
+    THnSparse *sparse = (THnSparse *) obj;
+    THn *dense = THn::CreateHn(sparse->GetName(), sparse->GetTitle(), sparse);
+    if (dense == NULL) {
+      AliErrorClass(Form("Sparse histogram %s could not be expanded", sparse->GetName()));
+      continue;
+    }
+    list->RemoveAt(i);
+    list->AddAt(dense, i);
+    delete sparse;
+    nExpanded++;
+  }
+  return nExpanded;
+}
+
+/// Counts recursively the THnSparse histograms of a list
+/// \param list the histograms list
+/// \return the number of THnSparse histograms
+Int_t AliQnCorrectionsSparseHistograms::CountSparse(const TList *list) {
+
+  Int_t nSparse = 0;
+  TIter next(list);
+  TObject *obj;
+  while ((obj = next()) != NULL) {
+    if (obj->InheritsFrom(TList::Class()))
+      nSparse += CountSparse((const TList *) obj);
+    else if (obj->InheritsFrom(THnSparse::Class()))
+      nSparse++;
+  }
+  return nSparse;
+}
+
+/// Creates an in memory copy of a histograms file with its THnSparse histograms expanded
+///
+/// The keys classes are checked first and only the lists are read, the
+/// copy is only built if a THnSparse histogram is found. The lists read
+/// while checking are reused for the copy. Each key, in its latest cycle,
+/// is stored with the same name in the new file.
+/// \param file the histograms file
+/// \return the in memory file, NULL if the file had nothing to expand
+TFile *AliQnCorrectionsSparseHistograms::CreateDenseFile(TFile *file) {
+
+  TList *keys = file->GetListOfKeys();
+  TObjArray lists(keys->GetEntries());
+  lists.SetOwner(kTRUE);
+  Int_t nSparse = 0;
+
+  for (Int_t ikey = 0; ikey < keys->GetEntries(); ikey++) {
+    TKey *key = (TKey *) keys->At(ikey);
+    /* only the latest cycle of each key */
+    if (file->GetKey(key->GetName()) != key) continue;
+
+    TClass *keyClass = TClass::GetClass(key->GetClassName());
+    if (keyClass == NULL) continue;
+    if (keyClass->InheritsFrom(THnSparse::Class()))
+      nSparse++;
+    else if (keyClass->InheritsFrom(TList::Class())) {
+      TList *list = (TList *) key->ReadObj();
+      if (list == NULL) continue;
+      list->SetOwner(kTRUE);
+      nSparse += CountSparse(list);
+      lists.AddAt(list, ikey);
+    }
+  }
+  if (nSparse == 0) return NULL;
+
+  TDirectory *current = gDirectory;
+  TMemFile *denseFile = new TMemFile(Form("%s.dense", file->GetName()), "RECREATE");
+  Int_t nExpanded = 0;
+
+  for (Int_t ikey = 0; ikey < keys->GetEntries(); ikey++) {
+    TKey *key = (TKey *) keys->At(ikey);
+    if (file->GetKey(key->GetName()) != key) continue;
+
+    TObject *obj = lists.RemoveAt(ikey);
+    if (obj != NULL)
+      nExpanded += ExpandSparse((TList *) obj);
+    else {
+      obj = key->ReadObj();
+      if (obj == NULL) continue;
+      if (obj->InheritsFrom(TList::Class()))
+        ((TList *) obj)->SetOwner(kTRUE);
+      else if (obj->InheritsFrom(THnSparse::Class())) {
+        THn *dense = THn::CreateHn(obj->GetName(), obj->GetTitle(), (THnSparse *) obj);
+        if (dense != NULL) {
+          delete obj;
+          obj = dense;
+          nExpanded++;
+        }
+      }
+    }
+    denseFile->cd();
+    obj->Write(key->GetName(), TObject::kSingleKey);
+    delete obj;
+  }
+
+  if (current != NULL) current->cd();
+
+  AliInfoClass(Form("%d sparse histograms expanded from file %s", nExpanded, file->GetName()));
+  return denseFile;
+}
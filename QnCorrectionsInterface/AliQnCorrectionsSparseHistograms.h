@@ -0,0 +1,48 @@
+#ifndef ALIQNCORRECTIONS_SPARSEHISTOGRAMS_H
+#define ALIQNCORRECTIONS_SPARSEHISTOGRAMS_H
+
+/***************************************************************************
+ * Package:       FlowVectorCorrections ALICE glue                         *
+ * Authors:       Jaap Onderwaater, GSI, jacobus.onderwaater@cern.ch       *
+ *                Ilya Selyuzhenkov, GSI, ilya.selyuzhenkov@gmail.com      *
+ *                Víctor González, UCM, victor.gonzalez@cern.ch            *
+ *                Contributors are mentioned in the code where appropriate.*
+ * Development:   2014-2016                                                *
+ ***************************************************************************/
+
+/// \file AliQnCorrectionsSparseHistograms.h
+/// \brief Sparse storage of the calibration and QA histograms lists
+///
+/// The multidimensional calibration and QA histograms are dense THn objects
+/// over the event classes and, for the channelized detectors, the channels.
+/// Most of their bins use to be empty. For storage the dense THn histograms
+/// of a list are replaced by THnSparse ones with the same name, which only
+/// keep the filled bins and merge as the dense ones. When the histograms
+/// are loaded again the THnSparse histograms are expanded to dense THn ones
+/// of the same type so the framework finds them, by name, as it always did.
+
+#include <TObject.h>
+
+class TList;
+class TFile;
+
+class AliQnCorrectionsSparseHistograms : public TObject {
+public:
+  AliQnCorrectionsSparseHistograms();
+  virtual ~AliQnCorrectionsSparseHistograms();
+
+  static TList *CreateSparseCopy(const TList *list);
+  static Int_t ExpandSparse(TList *list);
+  static TFile *CreateDenseFile(TFile *file);
+
+private:
+  static TList *CopyList(const TList *list);
+  static Int_t CountSparse(const TList *list);
+
+  AliQnCorrectionsSparseHistograms(const AliQnCorrectionsSparseHistograms &c);
+  AliQnCorrectionsSparseHistograms& operator= (const AliQnCorrectionsSparseHistograms &c);
+
+  ClassDef(AliQnCorrectionsSparseHistograms, 1);
+};
+
+#endif // ALIQNCORRECTIONS_SPARSEHISTOGRAMS_H
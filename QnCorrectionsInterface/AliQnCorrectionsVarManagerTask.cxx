@@ -72,6 +72,7 @@ const Char_t* AliQnCorrectionsVarManagerTask::fOfflineTriggerNames[64] = {
 void AliQnCorrectionsVarManagerTask::SetDefaultVarNames() {
   fVariableNames[kRandom1][0]              = "User";                            fVariableNames[kRandom1][1] = "";
   fVariableNames[kRunNo][0]                = "Run number";                      fVariableNames[kRunNo][1] = "";
+  fVariableNames[kRunIndex][0]             = "Run";                             fVariableNames[kRunIndex][1] = "";
   fVariableNames[kLHCFillNumber][0]        = "LHC fill number";                 fVariableNames[kLHCFillNumber][1] = ""; 
   fVariableNames[kBeamEnergy][0]           = "Beam energy";                     fVariableNames[kBeamEnergy][1] = "GeV";
   fVariableNames[kDetectorMask][0]         = "Detector mask";                   fVariableNames[kDetectorMask][1] = "";
@@ -160,6 +160,7 @@ public:
     kTZEROCemptyChannels, 			 // Number of empty TZERO channels in C side          
     kTZEROChannelMulttmp,      // For filling histograms with correct weight
     kTZEROChannel,      // For filling histograms at correct bin
+    kRunIndex,          // index of the run in the configured runs list, -1 if not there
     kNEventVars,           // number of event variables
     // Track variables -------------------------------------
     kPt,               
@@ -6,8 +6,18 @@
 
 #pragma link C++ class AliAnalysisTaskFlowVectorCorrections+;
 #pragma link C++ class AliAnalysisTaskQnVectorAnalysis+;
+#pragma link C++ class AliQnCorrectionsCalibrationCache+;
+#pragma link C++ class AliQnCorrectionsCalibrationConverter+;
+#pragma link C++ class AliQnCorrectionsCalibrationFetcher+;
+#pragma link C++ class AliQnCorrectionsCalibrationParameters+;
+#pragma link C++ class AliQnCorrectionsColumnarReader+;
+#pragma link C++ class AliQnCorrectionsColumnarWriter+;
 #pragma link C++ class AliQnCorrectionsFillEventTask+;
 #pragma link C++ class AliQnCorrectionsHistos+;
+#pragma link C++ class AliQnCorrectionsLocalCalibrationFetcher+;
+#pragma link C++ class AliQnCorrectionsProfileAccumulator+;
+#pragma link C++ class AliQnCorrectionsRunIndexedCalibration+;
+#pragma link C++ class AliQnCorrectionsSparseHistograms+;
 #pragma link C++ class AliQnCorrectionsVarManagerTask+;
 
 #endif